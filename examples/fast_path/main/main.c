@@ -0,0 +1,92 @@
+// Mide ciclos de CPU por lectura de angulo con esp_cpu_get_cycle_count:
+// mt6835_get_angle (4 lecturas), mt6835_get_angle_burst y mt6835_fast_get_angle (bus tomado, polling)
+// Ajustar los pines de abajo a la placa
+
+#include <stdio.h>
+#include "sdkconfig.h"
+#include "esp_cpu.h"
+#include "mt6835.h"
+
+#define PIN_MOSI    23
+#define PIN_MISO    19
+#define PIN_SCLK    18
+#define PIN_CS      5
+#define SPI_HOST_ID SPI2_HOST
+#define SPI_HZ      (8 * 1000 * 1000)
+
+#define LECTURAS    1000
+
+static const char *tag = "fast_path";
+
+typedef esp_err_t (*lectura_t)(spi_device_handle_t *mt6835Handle, uint32_t *angle);
+
+static void medir(const char *nombre, spi_device_handle_t *handle, lectura_t lectura) {
+    uint32_t minimo = UINT32_MAX, maximo = 0, fallas = 0;
+    uint64_t total = 0;
+    uint32_t angle;
+
+    for (int i = 0; i < LECTURAS; i++) {
+        uint32_t inicio = esp_cpu_get_cycle_count();
+        esp_err_t error = lectura(handle, &angle);
+        uint32_t ciclos = esp_cpu_get_cycle_count() - inicio;
+
+        if (error != ESP_OK) {
+            fallas++;
+            continue;
+        }
+
+        total += ciclos;
+        minimo = (ciclos < minimo) ? ciclos : minimo;
+        maximo = (ciclos > maximo) ? ciclos : maximo;
+    }
+
+    if (fallas == LECTURAS) {
+        printf("%-16s todas las lecturas fallaron\n", nombre);
+        return;
+    }
+
+    uint32_t promedio = total / (LECTURAS - fallas);
+
+    printf("%-16s min %7lu  prom %7lu  max %7lu ciclos  (prom %lu us)  fallas %lu\n", nombre,
+           (unsigned long)minimo, (unsigned long)promedio, (unsigned long)maximo,
+           (unsigned long)(promedio / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ), (unsigned long)fallas);
+}
+
+void app_main(void) {
+    spi_device_handle_t handle;
+
+    // DMA y max_transfer_sz para las lecturas de la tabla NLC y los snapshots (ver MT6835_MAX_TRANSFER)
+    spi_bus_config_t bus = {
+        .mosi_io_num = PIN_MOSI,
+        .miso_io_num = PIN_MISO,
+        .sclk_io_num = PIN_SCLK,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = MT6835_MAX_TRANSFER
+    };
+
+    // 4 bits de comando + 12 de direccion, modo 3. Los callbacks marcan inicio y fin de cada transaccion
+    spi_device_interface_config_t dispositivo = {
+        .command_bits = 4,
+        .address_bits = 12,
+        .mode = 3,
+        .clock_speed_hz = SPI_HZ,
+        .spics_io_num = PIN_CS,
+        .queue_size = MT6835_QUEUE_SIZE,
+        .pre_cb = mt6835_spi_pre_cb,
+        .post_cb = mt6835_spi_post_cb
+    };
+
+    ESP_ERROR_CHECK(spi_bus_initialize(SPI_HOST_ID, &bus, SPI_DMA_CH_AUTO));
+    ESP_ERROR_CHECK(spi_bus_add_device(SPI_HOST_ID, &dispositivo, &handle));
+    ESP_ERROR_CHECK(mt6835_attach(&handle));
+
+    ESP_LOGI(tag, "%d lecturas por funcion, CPU a %d MHz", LECTURAS, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+
+    medir("get_angle", &handle, mt6835_get_angle);
+    medir("get_angle_burst", &handle, mt6835_get_angle_burst);
+
+    ESP_ERROR_CHECK(mt6835_fast_begin(&handle));
+    medir("fast_get_angle", &handle, mt6835_fast_get_angle);
+    ESP_ERROR_CHECK(mt6835_fast_end(&handle));
+}
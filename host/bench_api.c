@@ -0,0 +1,233 @@
+// Benchmark de las funciones publicas del driver contra el modelo del MT6835
+// Reporta transacciones, bytes en el cable y ns de CPU por llamada
+// Uso: mt6835_bench_api [iteraciones]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "mt6835_sim.h"
+
+static mt6835_sim_t sim;
+static mt6835_sim_t ejes[MT6835_SCHED_MAX_AXES];
+static spi_device_handle_t handle;
+static mt6835_sched_t sched;
+static mt6835_stream_t stream;
+static mt6835_snapshot_t snapshot;
+static uint8_t tabla[MT6835_NLC_SIZE];
+
+static esp_err_t b_get_user_id(uint32_t i) { uint8_t v; return mt6835_get_user_id(&handle, &v); }
+static esp_err_t b_set_user_id(uint32_t i) { return mt6835_set_user_id(&handle, i & 0xFF); }
+static esp_err_t b_get_angle(uint32_t i) { uint32_t a; return mt6835_get_angle(&handle, &a); }
+static esp_err_t b_get_angle_burst(uint32_t i) { uint32_t a; return mt6835_get_angle_burst(&handle, &a); }
+static esp_err_t b_fast_get_angle(uint32_t i) { uint32_t a; return mt6835_fast_get_angle(&handle, &a); }
+static esp_err_t b_get_abz_res(uint32_t i) { uint16_t r; return mt6835_get_abz_res(&handle, &r); }
+static esp_err_t b_set_abz_res(uint32_t i) { return mt6835_set_abz_res(&handle, 1000 + (i & 1)); }
+
+static esp_err_t b_get_abz_res_fria(uint32_t i) {
+    uint16_t r;
+    mt6835_cache_invalidate(&handle);
+    return mt6835_get_abz_res(&handle, &r);
+}
+
+static esp_err_t b_set_z_phase(uint32_t i) { return mt6835_set_z_phase(&handle, i & 0x03); }
+static esp_err_t b_set_bw(uint32_t i) { return mt6835_set_bw(&handle, i & 0x07); }
+static esp_err_t b_cache_refresh(uint32_t i) { return mt6835_cache_refresh(&handle); }
+static esp_err_t b_config_read(uint32_t i) { mt6835_config_t c; return mt6835_config_read(&handle, &c); }
+
+static esp_err_t b_config_apply(uint32_t i) {
+    mt6835_config_t c;
+    esp_err_t error = mt6835_config_read(&handle, &c);
+
+    if (error != ESP_OK) {
+        return error;
+    }
+
+    c.abzRes = 2000 + (i & 1);
+    c.bw = i & 0x07;
+    return mt6835_config_apply(&handle, &c);
+}
+
+static esp_err_t b_set_cur_position_zero(uint32_t i) { return mt6835_set_cur_position_zero(&handle); }
+static esp_err_t b_set_zero_fine(uint32_t i) { return mt6835_set_zero_fine(&handle, (i * 7919) & MT6835_ANGLE21_MASK); }
+static esp_err_t b_nlc_read(uint32_t i) { return mt6835_nlc_read(&handle, tabla); }
+
+static esp_err_t b_nlc_write(uint32_t i) {
+    tabla[i % MT6835_NLC_SIZE] ^= 0x01;
+    return mt6835_nlc_write(&handle, tabla);
+}
+
+static esp_err_t b_snapshot_read(uint32_t i) { return mt6835_snapshot_read(&handle, &snapshot, 1); }
+static esp_err_t b_snapshot_restore(uint32_t i) { return mt6835_snapshot_restore(&handle, &snapshot); }
+
+static esp_err_t b_get_foc(uint32_t i) {
+    mt6835_foc_t foc = { .polePairs = 7, .elecOffset = 0 };
+    mt6835_foc_sample_t m;
+    return mt6835_get_foc(&handle, &foc, &m);
+}
+
+static esp_err_t b_read_async(uint32_t i) {
+    uint32_t a;
+    esp_err_t error = mt6835_read_start(&handle, NULL, NULL);
+
+    if (error != ESP_OK) {
+        return error;
+    }
+
+    return mt6835_read_collect(&handle, &a, 0);
+}
+
+static esp_err_t b_read_pipeline(uint32_t i) { uint32_t a; return mt6835_read_collect(&handle, &a, 0); }
+
+static esp_err_t b_latest_acquire(uint32_t i) { return mt6835_latest_acquire(&handle); }
+static esp_err_t b_latest_read(uint32_t i) { mt6835_latest_t m; return mt6835_latest_read(&handle, NULL, &m); }
+
+static esp_err_t b_stream_service(uint32_t i) {
+    mt6835_sample_t m;
+    esp_err_t error = mt6835_stream_service(&stream, 0);
+
+    while (mt6835_ring_pop(&stream.ring, &m)) {
+    }
+
+    return error;
+}
+
+static esp_err_t b_sched_read(uint32_t i) { mt6835_sched_sample_t m; return mt6835_sched_read(&sched, &m); }
+
+typedef struct {
+    const char *nombre;
+    esp_err_t (*funcion)(uint32_t i);
+    void (*antes)(void);
+    void (*despues)(void);
+    mt6835_sim_t *modelo;       // NULL = sim
+} bench_t;
+
+static void fast_begin(void) { mt6835_fast_begin(&handle); }
+static void fast_end(void) { mt6835_fast_end(&handle); }
+static void pipeline_start(void) { mt6835_read_pipeline(&handle, 1); mt6835_read_start(&handle, NULL, NULL); }
+
+static void pipeline_stop(void) {
+    uint32_t a;
+    mt6835_read_pipeline(&handle, 0);
+    mt6835_read_collect(&handle, &a, 0);
+}
+
+static void stream_start(void) { mt6835_stream_start(&handle, &stream); }
+static void stream_stop(void) { mt6835_stream_stop(&stream); }
+
+static const bench_t benchs[] = {
+    { "get_user_id", b_get_user_id },
+    { "set_user_id", b_set_user_id },
+    { "get_angle", b_get_angle },
+    { "get_angle_burst", b_get_angle_burst },
+    { "fast_get_angle", b_fast_get_angle, fast_begin, fast_end },
+    { "get_abz_res", b_get_abz_res },
+    { "get_abz_res (cache fria)", b_get_abz_res_fria },
+    { "set_abz_res", b_set_abz_res },
+    { "set_z_phase", b_set_z_phase },
+    { "set_bw", b_set_bw },
+    { "cache_refresh", b_cache_refresh },
+    { "config_read", b_config_read },
+    { "config_apply", b_config_apply },
+    { "set_cur_position_zero", b_set_cur_position_zero },
+    { "set_zero_fine", b_set_zero_fine },
+    { "nlc_read", b_nlc_read },
+    { "nlc_write (1 byte distinto)", b_nlc_write },
+    { "snapshot_read (con NLC)", b_snapshot_read },
+    { "snapshot_restore (igual)", b_snapshot_restore },
+    { "get_foc", b_get_foc },
+    { "read_start + read_collect", b_read_async },
+    { "read_collect (pipeline)", b_read_pipeline, pipeline_start, pipeline_stop },
+    { "latest_acquire", b_latest_acquire },
+    { "latest_read", b_latest_read },
+    { "stream_service", b_stream_service, stream_start, stream_stop },
+    { "sched_read (por pasada)", b_sched_read, NULL, NULL, ejes },
+};
+
+static int64_t ahora_ns(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return (int64_t)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    uint32_t iteraciones = (argc > 1) ? strtoul(argv[1], NULL, 0) : 10000;
+    int fallas = 0;
+
+    if (iteraciones == 0) {
+        iteraciones = 1;
+    }
+
+    mt6835_set_transport(&mt6835_sim_transport);
+    mt6835_sim_init(&sim);
+    sim.velocity = 1000;
+    handle = mt6835_sim_handle(&sim);
+    mt6835_attach(&handle);
+
+    mt6835_sched_init(&sched);
+
+    for (int i = 0; i < MT6835_SCHED_MAX_AXES; i++) {
+        static spi_device_handle_t handles[MT6835_SCHED_MAX_AXES];
+
+        mt6835_sim_init(&ejes[i]);
+        ejes[i].velocity = 100 * (i + 1);
+        handles[i] = mt6835_sim_handle(&ejes[i]);
+        mt6835_attach(&handles[i]);
+        mt6835_sched_add(&sched, &handles[i]);
+    }
+
+    mt6835_snapshot_read(&handle, &snapshot, 1);
+
+    printf("%-30s %10s %10s %10s\n", "funcion", "trans", "bytes", "ns");
+
+    for (size_t b = 0; b < sizeof(benchs) / sizeof(benchs[0]); b++) {
+        const bench_t *bench = &benchs[b];
+        uint32_t transacciones = 0, bytes = 0;
+
+        if (bench->antes != NULL) {
+            bench->antes();
+        }
+
+        mt6835_sim_reset_stats(&sim);
+
+        for (int i = 0; i < MT6835_SCHED_MAX_AXES; i++) {
+            mt6835_sim_reset_stats(&ejes[i]);
+        }
+
+        int64_t inicio = ahora_ns();
+
+        for (uint32_t i = 0; i < iteraciones; i++) {
+            if (bench->funcion(i) != ESP_OK) {
+                fallas++;
+                break;
+            }
+        }
+
+        int64_t fin = ahora_ns();
+
+        if (bench->modelo != NULL) {
+            for (int i = 0; i < MT6835_SCHED_MAX_AXES; i++) {
+                transacciones += bench->modelo[i].transactions;
+                bytes += bench->modelo[i].bytes;
+            }
+        } else {
+            transacciones = sim.transactions;
+            bytes = sim.bytes;
+        }
+
+        if (bench->despues != NULL) {
+            bench->despues();
+        }
+
+        printf("%-30s %10.2f %10.2f %10.1f\n", bench->nombre, (double)transacciones / iteraciones,
+               (double)bytes / iteraciones, (double)(fin - inicio) / iteraciones);
+    }
+
+    if (fallas > 0) {
+        printf("%d funciones fallaron\n", fallas);
+        return 1;
+    }
+
+    return 0;
+}
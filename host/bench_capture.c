@@ -0,0 +1,162 @@
+// Formato de captura: relacion de compresion, muestras/s de codificacion y decodificacion,
+// ida y vuelta exacta y decodificacion empezando en un keyframe intermedio
+// Uso: mt6835_bench_capture [muestras]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "mt6835_capture.h"
+
+#define SIN_COMPRIMIR 12        // Timestamp int64 + 3 bytes de angulo y estado + CRC
+
+static mt6835_sample_t *entrada, *salida;
+static uint8_t *buf;
+static uint32_t semilla = 1;
+
+static uint32_t aleatorio(uint32_t n) {
+    semilla = semilla * 1664525 + 1013904223;
+    return (semilla >> 8) % n;
+}
+
+static int64_t ahora_ns(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return (int64_t)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static int iguales(const mt6835_sample_t *a, const mt6835_sample_t *b) {
+    return a->raw == b->raw && a->timestamp == b->timestamp && a->crcOk == b->crcOk && (a->crcOk || a->crc == b->crc);
+}
+
+static int correr(const char *nombre, uint32_t muestras) {
+    mt6835_capture_t enc, dec;
+    size_t largo = 0, leido = 0;
+
+    mt6835_capture_init(&enc, 0);
+
+    int64_t inicio = ahora_ns();
+
+    for (uint32_t i = 0; i < muestras; i++) {
+        size_t n = mt6835_capture_encode(&enc, &entrada[i], &buf[largo], (size_t)muestras * MT6835_CAPTURE_MAX_RECORD - largo);
+
+        if (n == 0) {
+            printf("%s: buffer lleno en la muestra %lu\n", nombre, (unsigned long)i);
+            return 1;
+        }
+
+        largo += n;
+    }
+
+    int64_t medio = ahora_ns();
+
+    mt6835_capture_init(&dec, 0);
+
+    for (uint32_t i = 0; i < muestras; i++) {
+        size_t n = mt6835_capture_decode(&dec, &buf[leido], largo - leido, &salida[i]);
+
+        if (n == 0) {
+            printf("%s: no se pudo decodificar la muestra %lu\n", nombre, (unsigned long)i);
+            return 1;
+        }
+
+        leido += n;
+    }
+
+    int64_t fin = ahora_ns();
+
+    for (uint32_t i = 0; i < muestras; i++) {
+        if (!iguales(&entrada[i], &salida[i])) {
+            printf("%s: la muestra %lu no coincide\n", nombre, (unsigned long)i);
+            return 1;
+        }
+    }
+
+    // Acceso aleatorio: un decodificador nuevo arranca en el keyframe de la muestra 100 * MT6835_CAPTURE_KEYFRAME
+    uint32_t keyframe = 100 * MT6835_CAPTURE_KEYFRAME;
+
+    if (keyframe < muestras) {
+        size_t pos = 0;
+        mt6835_sample_t muestra;
+        mt6835_capture_t salto;
+
+        // Solo para ubicar el byte donde empieza el keyframe
+        mt6835_capture_init(&salto, 0);
+
+        for (uint32_t i = 0; i < keyframe; i++) {
+            pos += mt6835_capture_decode(&salto, &buf[pos], largo - pos, &muestra);
+        }
+
+        mt6835_capture_init(&dec, 0);
+
+        if (mt6835_capture_decode(&dec, &buf[pos], largo - pos, &muestra) == 0 || !iguales(&muestra, &entrada[keyframe])) {
+            printf("%s: no se pudo decodificar desde el keyframe %lu\n", nombre, (unsigned long)keyframe);
+            return 1;
+        }
+    }
+
+    printf("%-12s %10.2f %10.1fx %12.1f %12.1f\n", nombre, (double)largo / muestras, (double)SIN_COMPRIMIR * muestras / largo,
+           muestras * 1e3 / (medio - inicio), muestras * 1e3 / (fin - medio));
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    uint32_t muestras = (argc > 1) ? strtoul(argv[1], NULL, 0) : 2000000;
+    uint32_t angulo;
+    int64_t timestamp;
+    int fallas = 0;
+
+    if (muestras == 0) {
+        muestras = 1;
+    }
+
+    entrada = malloc(muestras * sizeof(*entrada));
+    salida = malloc(muestras * sizeof(*salida));
+    buf = malloc((size_t)muestras * MT6835_CAPTURE_MAX_RECORD);
+
+    if (entrada == NULL || salida == NULL || buf == NULL) {
+        printf("Sin memoria para %lu muestras\n", (unsigned long)muestras);
+        return 1;
+    }
+
+    printf("%-12s %10s %11s %12s %12s\n", "captura", "B/muestra", "relacion", "enc Mm/s", "dec Mm/s");
+
+    // Velocidad y periodo constantes: el caso ideal, 1 byte por muestra
+    angulo = 0;
+    timestamp = 0;
+
+    for (uint32_t i = 0; i < muestras; i++) {
+        angulo = (angulo + 1234) & 0x1FFFFF;
+        timestamp += 100;
+        entrada[i] = (mt6835_sample_t) { .timestamp = timestamp, .raw = angulo << 3, .crcOk = 1 };
+    }
+
+    fallas += correr("constante", muestras);
+
+    // Ruido de +-3 cuentas, jitter de +-2 us, algun bit de estado y algun CRC invalido
+    angulo = 0;
+    timestamp = 0;
+
+    for (uint32_t i = 0; i < muestras; i++) {
+        int crcMalo = aleatorio(5000) == 0;
+
+        angulo = (angulo + 1234 + aleatorio(7) - 3) & 0x1FFFFF;
+        timestamp += 100 + aleatorio(5) - 2;
+        entrada[i] = (mt6835_sample_t) {
+            .timestamp = timestamp,
+            .raw = (angulo << 3) | ((aleatorio(1000) == 0) ? 0x02 : 0x00),
+            .crc = crcMalo ? 0xAB : 0x00,
+            .crcOk = !crcMalo
+        };
+    }
+
+    fallas += correr("con jitter", muestras);
+
+    free(entrada);
+    free(salida);
+    free(buf);
+
+    return fallas ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+// CRC por tabla contra la version bit a bit original (la de SimpleFOC)
+// Verifica las 2^24 palabras crudas, mt6835_check_crc_batch y mide ns por CRC
+// Uso: mt6835_bench_crc [repeticiones]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "mt6835.h"
+
+// Referencia: bit a bit sobre los 3 bytes de la palabra cruda (ANGLE_HIGH, ANGLE_MID, ANGLE_LOW)
+static uint8_t crc_bitwise(uint32_t raw) {
+    uint8_t crc = 0x00;
+
+    for (int byte = 2; byte >= 0; byte--) {
+        crc ^= (raw >> (8 * byte)) & 0xFF;
+
+        for (int k = 8; k > 0; k--) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+static int64_t ahora_ns(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return (int64_t)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    uint32_t repeticiones = (argc > 1) ? strtoul(argv[1], NULL, 0) : 4;
+    volatile uint8_t sumidero = 0;
+    int fallas = 0;
+
+    // 1) Igualdad exacta en todo el dominio
+    for (uint32_t raw = 0; raw < (1u << 24); raw++) {
+        if (crc_bitwise(raw) != calculate_crc_raw(raw)) {
+            printf("calculate_crc_raw(0x%06lX) = 0x%02X, esperado 0x%02X\n", (unsigned long)raw, calculate_crc_raw(raw), crc_bitwise(raw));
+            fallas++;
+            break;
+        }
+    }
+
+    for (uint32_t angle = 0; angle < (1u << 21); angle++) {
+        if (crc_bitwise(angle << 3) != calculate_crc(angle)) {
+            printf("calculate_crc(0x%06lX) distinto de la referencia\n", (unsigned long)angle);
+            fallas++;
+            break;
+        }
+    }
+
+    printf("%-24s %s\n", "2^24 palabras crudas", fallas ? "FALLA" : "iguales");
+
+    // 2) Lote con dos CRC corrompidos: tienen que aparecer exactamente esos bits
+    static uint32_t raw[1000];
+    static uint8_t crc[1000];
+    uint32_t bitmap[(1000 + 31) / 32];
+
+    for (int i = 0; i < 1000; i++) {
+        raw[i] = (i * 7919u) & 0xFFFFFF;
+        crc[i] = crc_bitwise(raw[i]);
+    }
+
+    crc[5] ^= 0x01;
+    crc[999] ^= 0x80;
+
+    uint32_t batch = mt6835_check_crc_batch(raw, crc, 1000, bitmap);
+
+    if (batch != 2 || bitmap[0] != (1u << 5) || bitmap[31] != (1u << (999 % 32))) {
+        printf("mt6835_check_crc_batch: %lu fallas, bitmap[0] = 0x%08lX\n", (unsigned long)batch, (unsigned long)bitmap[0]);
+        fallas++;
+    }
+
+    // 3) Velocidad
+    int64_t inicio = ahora_ns();
+
+    for (uint32_t r = 0; r < repeticiones; r++) {
+        for (uint32_t x = 0; x < (1u << 21); x++) {
+            sumidero ^= crc_bitwise(x + r);
+        }
+    }
+
+    int64_t bitwise = ahora_ns() - inicio;
+
+    inicio = ahora_ns();
+
+    for (uint32_t r = 0; r < repeticiones; r++) {
+        for (uint32_t x = 0; x < (1u << 21); x++) {
+            sumidero ^= calculate_crc_raw(x + r);
+        }
+    }
+
+    int64_t tabla = ahora_ns() - inicio;
+    double n = (double)repeticiones * (1u << 21);
+
+    printf("%-24s %10.2f ns\n", "bit a bit", bitwise / n);
+    printf("%-24s %10.2f ns\n", "tabla", tabla / n);
+    printf("%-24s %10.1fx\n", "mejora", (double)bitwise / (tabla > 0 ? tabla : 1));
+
+    return fallas ? 1 : 0;
+}
@@ -0,0 +1,196 @@
+// Compensacion de retardo: error del angulo medido contra el predicho con mt6835_observer_predict
+// para retardos aleatorios de 20 a 120 us entre la adquisicion y el uso, a varias velocidades.
+// Despues lo mismo de punta a punta contra el modelo: lecturas burst cada 1 ms de un eje que gira en
+// tiempo real, mt6835_get_timing y mt6835_predict_angle al fin de la transaccion mas ADELANTO_US
+// Uso: mt6835_bench_predict
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "esp_timer.h"
+#include "mt6835_sim.h"
+
+#define FS          10000       // Hz
+#define BW          1000        // Hz
+#define MUESTRAS    100000
+#define TRANSITORIO 2000        // Muestras descartadas al inicio
+#define VUELTA      2097152.0   // Cuentas de 21 bits por vuelta
+
+// Contra el modelo, en tiempo real
+#define FS_SIM          1000    // Hz
+#define BW_SIM          100     // Hz
+#define MUESTRAS_SIM    500
+#define TRANSITORIO_SIM 200
+#define RPM_SIM         600
+#define ADELANTO_US     100     // Uso del angulo despues del fin de la transaccion
+#define MEJORA_SIM      10      // Error sin compensar / compensado minimo
+
+typedef struct {
+    uint32_t rpm;
+    double maxCompensado;       // Cuentas
+} caso_t;
+
+static const caso_t casos[] = {
+    { 1000, 16 },
+    { 6000, 16 },
+    { 20000, 16 },
+    { 60000, 16 },
+};
+
+static uint32_t semilla = 7;
+
+static uint32_t aleatorio(uint32_t n) {
+    semilla = semilla * 1664525 + 1013904223;
+    return (semilla >> 8) % n;
+}
+
+static uint32_t angulo21(double cuentas) {
+    return (uint32_t)llround(fmod(cuentas, VUELTA)) & 0x1FFFFF;
+}
+
+static mt6835_sim_t sim;
+static int64_t origen;
+static double velocidadSim;     // Cuentas/us
+
+static uint32_t angulo_real(int64_t t) {
+    return angulo21(velocidadSim * (t - origen) + 12345);
+}
+
+// Antes de cada transaccion el modelo toma el angulo de un eje que gira a velocidad constante en tiempo real
+static esp_err_t transmit(spi_device_handle_t handle, spi_transaction_t *trans) {
+    sim.angle = angulo_real(esp_timer_get_time());
+
+    return mt6835_sim_transport.transmit(handle, trans);
+}
+
+static int comparar(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+static int probar_modelo(void) {
+    static mt6835_transport_t transporte;
+    spi_device_handle_t handle;
+    mt6835_observer_t obs;
+    mt6835_timing_t timing;
+    uint32_t raw, predicho, n = 0, tiempos = 0;
+    static double errores[MUESTRAS_SIM], erroresComp[MUESTRAS_SIM];
+
+    transporte = mt6835_sim_transport;
+    transporte.transmit = transmit;
+    mt6835_sim_init(&sim);
+    mt6835_set_transport(&transporte);
+    handle = mt6835_sim_handle(&sim);
+    mt6835_attach(&handle);
+    mt6835_observer_init(&obs, BW_SIM, FS_SIM);
+
+    velocidadSim = RPM_SIM / 60.0 * VUELTA / 1e6;
+    origen = esp_timer_get_time();
+
+    for (uint32_t i = 0; i < MUESTRAS_SIM; i++) {
+        int64_t siguiente = origen + (int64_t)(i + 1) * 1000000 / FS_SIM;
+
+        while (esp_timer_get_time() < siguiente) {
+        }
+
+        if (mt6835_get_angle_burst(&handle, &raw) != ESP_OK || mt6835_get_timing(&handle, &timing) != ESP_OK) {
+            return 1;
+        }
+
+        mt6835_observer_update(&obs, raw);
+        tiempos += timing.inicio == 0 || timing.fin < timing.inicio || timing.latencia != timing.fin - timing.inicio;
+
+        if (i < TRANSITORIO_SIM) {
+            continue;
+        }
+
+        int64_t objetivo = timing.fin + ADELANTO_US;
+
+        if (mt6835_predict_angle(&handle, &obs, objetivo, &predicho) != ESP_OK) {
+            return 1;
+        }
+
+        uint32_t real = angulo_real(objetivo);
+        errores[n] = fabs((double)mt6835_angle21_diff(mt6835_raw_to_angle21(raw), real));
+        erroresComp[n] = fabs((double)mt6835_angle21_diff(predicho, real));
+        n++;
+    }
+
+    // Mediana: una muestra demorada por el scheduler del host desvia al observador, que supone FS_SIM fijo
+    qsort(errores, n, sizeof(double), comparar);
+    qsort(erroresComp, n, sizeof(double), comparar);
+
+    double mediana = errores[n / 2], medianaComp = erroresComp[n / 2];
+    int falla = tiempos != 0 || medianaComp * MEJORA_SIM > mediana;
+
+    printf("%-22s %8.1f -> %.1f cuentas (mediana), %d rpm, fin + %d us%s\n", "modelo", mediana, medianaComp, RPM_SIM,
+           ADELANTO_US, falla ? "  FALLA" : "");
+
+    return falla;
+}
+
+int main(void) {
+    int fallas = 0;
+
+    printf("%8s %14s %14s %14s %14s\n", "rpm", "sin comp rms", "sin comp max", "comp rms", "comp max");
+
+    for (size_t c = 0; c < sizeof(casos) / sizeof(casos[0]); c++) {
+        const caso_t *caso = &casos[c];
+        double velocidad = caso->rpm / 60.0 * VUELTA;      // Cuentas/s
+        double suma = 0, maximo = 0, sumaComp = 0, maximoComp = 0;
+        mt6835_observer_t obs;
+        uint32_t n = 0;
+
+        semilla = 7;
+        mt6835_observer_init(&obs, BW, FS);
+
+        for (uint32_t i = 0; i < MUESTRAS; i++) {
+            double t = (double)i / FS;
+
+            // Medicion con +-2 cuentas de ruido
+            uint32_t medido = angulo21(velocidad * t + 12345 + aleatorio(5) - 2);
+
+            mt6835_observer_update(&obs, medido << 3);
+
+            if (i < TRANSITORIO) {
+                continue;
+            }
+
+            int32_t retardo = 20 + aleatorio(101);
+            uint32_t real = angulo21(velocidad * (t + retardo * 1e-6) + 12345);
+            double error = fabs((double)mt6835_angle21_diff(medido, real));
+            double errorComp = fabs((double)mt6835_angle21_diff(mt6835_observer_predict(&obs, retardo), real));
+
+            suma += error * error;
+            sumaComp += errorComp * errorComp;
+            maximo = fmax(maximo, error);
+            maximoComp = fmax(maximoComp, errorComp);
+            n++;
+        }
+
+        int falla = maximoComp > caso->maxCompensado;
+
+        printf("%8lu %14.1f %14.0f %14.1f %14.0f%s\n", (unsigned long)caso->rpm, sqrt(suma / n), maximo,
+               sqrt(sumaComp / n), maximoComp, falla ? "  FALLA" : "");
+        fallas += falla;
+    }
+
+    // Prediccion cruzando el cero: 100 cuentas por muestra, 500 us = 5 muestras mas adelante
+    mt6835_observer_t obs;
+
+    mt6835_observer_init(&obs, BW, FS);
+
+    for (uint32_t i = 0; i < 100; i++) {
+        mt6835_observer_update(&obs, ((2097000 + i * 100) & 0x1FFFFF) << 3);
+    }
+
+    uint32_t esperado = (2097000 + 99 * 100 + 500) & 0x1FFFFF;
+    int32_t error = mt6835_angle21_diff(mt6835_observer_predict(&obs, 500), esperado);
+
+    printf("%-22s %8ld cuentas%s\n", "error cruzando el cero", (long)error, (error < -2 || error > 2) ? "  FALLA" : "");
+    fallas += (error < -2 || error > 2);
+    fallas += probar_modelo();
+
+    return fallas ? 1 : 0;
+}
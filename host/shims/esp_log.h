@@ -0,0 +1,9 @@
+#pragma once
+
+// Shim de host: los logs van a stderr para no mezclarse con la salida de los benchmarks
+
+#include <stdio.h>
+
+#define ESP_LOGE(tag, formato, ...) fprintf(stderr, "E %s: " formato "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, formato, ...) fprintf(stderr, "W %s: " formato "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, formato, ...) fprintf(stderr, "I %s: " formato "\n", tag, ##__VA_ARGS__)
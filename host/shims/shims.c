@@ -0,0 +1,72 @@
+// Implementacion de host de las funciones de ESP-IDF que usa el driver
+// El bus SPI no existe: las funciones por defecto fallan, usar mt6835_set_transport(&mt6835_sim_transport)
+
+#include <stdio.h>
+#include <time.h>
+#include "driver/spi_master.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+
+const char *esp_err_to_name(esp_err_t error) {
+    switch (error) {
+        case ESP_OK:                    return "ESP_OK";
+        case ESP_FAIL:                  return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:       return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:     return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:      return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:         return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:     return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:           return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE:  return "ESP_ERR_INVALID_RESPONSE";
+        case ESP_ERR_INVALID_CRC:       return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_NOT_FINISHED:      return "ESP_ERR_NOT_FINISHED";
+        default:                        return "ERROR";
+    }
+}
+
+static int64_t ahora_ns(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return (int64_t)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+int64_t esp_timer_get_time(void) {
+    return ahora_ns() / 1000;
+}
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void) {
+    return (esp_cpu_cycle_count_t)ahora_ns();
+}
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec t = { .tv_sec = ticks / 1000, .tv_nsec = (long)(ticks % 1000) * 1000000L };
+
+    nanosleep(&t, NULL);
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t espera) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t espera) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t espera) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void spi_device_release_bus(spi_device_handle_t handle) {
+}
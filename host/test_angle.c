@@ -0,0 +1,97 @@
+// Conversiones de mt6835_angle.h contra referencias exactas en todo el dominio:
+// raw -> 21 bits, ida y vuelta 21 bits <-> Q32, redondeo de Q32 y de milesimas de grado,
+// y diferencia con signo cruzando el cero
+// Uso: mt6835_test_angle
+
+#include <stdio.h>
+#include "mt6835_angle.h"
+
+#define VUELTA (1u << 21)
+
+static int fallas;
+
+static void verificar(const char *nombre, uint32_t errores) {
+    printf("%-44s %s\n", nombre, errores ? "FALLA" : "ok");
+    fallas += errores != 0;
+}
+
+int main(void) {
+    uint32_t errores;
+
+    // 1) Palabra cruda de 24 bits: los bits de estado no llegan al angulo
+    errores = 0;
+
+    for (uint32_t raw = 0; raw < (1u << 24); raw++) {
+        errores += mt6835_raw_to_angle21(raw) != raw >> 3;
+    }
+
+    errores += mt6835_raw_to_angle21(0xFF000000) != 0;
+    verificar("raw -> 21 bits, 2^24 palabras", errores);
+
+    // 2) 21 bits -> Q32 -> 21 bits es exacto, y Q32 redondea al LSB mas cercano (medio LSB hacia arriba)
+    errores = 0;
+
+    for (uint32_t a = 0; a < VUELTA; a++) {
+        mt6835_turns_q32_t q = mt6835_angle21_to_q32(a);
+        static const int32_t desvios[] = { -1024, -1023, -1, 0, 1, 1023 };
+
+        errores += q != (uint32_t)((uint64_t)a << 32 >> 21);
+        errores += mt6835_q32_to_angle21(q) != a;
+
+        // Hasta medio LSB por debajo y por encima de a todavia redondea a a
+        for (int d = 0; d < 6; d++) {
+            errores += mt6835_q32_to_angle21(q + desvios[d]) != a;
+        }
+
+        errores += mt6835_q32_to_angle21(q + 1024) != ((a + 1) & (VUELTA - 1));
+    }
+
+    verificar("21 bits <-> Q32, 2^21 angulos y redondeo", errores);
+
+    // 3) Milesimas de grado contra la division entera redondeada
+    errores = 0;
+
+    for (uint32_t a = 0; a < VUELTA; a++) {
+        uint32_t mdeg = mt6835_angle21_to_mdeg(a);
+
+        errores += mdeg != (uint32_t)(((uint64_t)a * 360000 + VUELTA / 2) / VUELTA);
+
+        // 1 mdeg = 5.8 cuentas: la vuelta a 21 bits queda a menos de 3 cuentas
+        int32_t error = mt6835_angle21_diff(mt6835_mdeg_to_angle21(mdeg), a);
+
+        errores += error < -3 || error > 3;
+    }
+
+    for (uint32_t mdeg = 0; mdeg <= 360000; mdeg++) {
+        uint32_t a = mt6835_mdeg_to_angle21(mdeg);
+
+        errores += a != (uint32_t)((((uint64_t)mdeg << 21) + 180000) / 360000) % VUELTA;
+        errores += mt6835_angle21_to_mdeg(a) % 360000 != mdeg % 360000;
+    }
+
+    verificar("21 bits <-> mdeg, 2^21 angulos y 360001 mdeg", errores);
+
+    // 4) Diferencia con signo: rango [-2^20, 2^20) y b + diff(a, b) = a en toda la vuelta
+    static const uint32_t bases[] = { 0, 1, VUELTA / 2 - 1, VUELTA / 2, VUELTA / 2 + 1, VUELTA - 1, 1234567 };
+
+    errores = 0;
+
+    for (int k = 0; k < 7; k++) {
+        uint32_t b = bases[k];
+
+        for (uint32_t a = 0; a < VUELTA; a++) {
+            int32_t d = mt6835_angle21_diff(a, b);
+
+            errores += d < -(int32_t)(VUELTA / 2) || d >= (int32_t)(VUELTA / 2);
+            errores += ((b + d) & (VUELTA - 1)) != a;
+        }
+    }
+
+    errores += mt6835_angle21_diff(0, VUELTA - 1) != 1;
+    errores += mt6835_angle21_diff(VUELTA - 1, 0) != -1;
+    errores += mt6835_angle21_diff(VUELTA / 2, 0) != -(int32_t)(VUELTA / 2);
+    errores += mt6835_angle21_diff(5, VUELTA - 5) != 10;
+    verificar("diferencia con signo cruzando el cero", errores);
+
+    return fallas ? 1 : 0;
+}
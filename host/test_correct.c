@@ -0,0 +1,137 @@
+// Correcciones por software de la ruta de lectura:
+// - LUT armada con mt6835_lut_build a partir de una distorsion conocida, residuo despues de mt6835_lut_apply_batch
+//   en toda la vuelta y ns por muestra
+// - Cero fino contra el modelo: set_zero_fine sin registrar no escribe nada, y set_zero / set_cur_position_zero
+//   no dejan el resto de 9 bits de un set_zero_fine anterior
+// Uso: mt6835_test_correct
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "mt6835_sim.h"
+
+#define VUELTA      2097152
+#define PUNTOS      64          // Como la tabla NLC
+#define A1          500.0       // Cuentas, primer armonico
+#define A3          200.0       // Cuentas, tercer armonico
+#define MAX_RESIDUO 8           // Cuentas, interpolacion lineal de 64 puntos sobre el tercer armonico
+#define ANGULO      1234567     // Angulo mecanico del modelo
+
+static uint32_t raw[VUELTA];
+static int fallas;
+
+static void verificar(const char *nombre, int ok) {
+    printf("%-52s %s\n", nombre, ok ? "ok" : "FALLA");
+    fallas += !ok;
+}
+
+static int64_t ahora_ns(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return (int64_t)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static double distorsion(double theta) {
+    return A1 * sin(theta) + A3 * sin(3 * theta);
+}
+
+static void probar_lut(void) {
+    static mt6835_lut_t lut;
+    int32_t puntos[PUNTOS];
+    uint32_t copia[1024];
+    double suma = 0, sumaAntes = 0, maximo = 0, maximoAntes = 0;
+    uint32_t estado = 0, distintas = 0;
+
+    // Correccion = menos la distorsion en cada punto, indexada por el angulo medido
+    for (int j = 0; j < PUNTOS; j++) {
+        puntos[j] = -(int32_t)lround(distorsion(j * 2 * M_PI / PUNTOS));
+    }
+
+    mt6835_lut_build(&lut, puntos, PUNTOS);
+
+    verificar("build: ultimo tramo cierra la vuelta", lut.corr[MT6835_LUT_SIZE] == lut.corr[0]);
+    verificar("build: los tramos sobre un punto valen el punto",
+              lut.corr[0] == puntos[0] && lut.corr[MT6835_LUT_SIZE / 4] == puntos[PUNTOS / 4]);
+
+    // Medicion distorsionada de todos los angulos de la vuelta, con bits de estado para ver que se conservan
+    for (uint32_t a = 0; a < VUELTA; a++) {
+        uint32_t medido = (uint32_t)llround(a + distorsion(a * 2 * M_PI / VUELTA)) & MT6835_ANGLE21_MASK;
+
+        raw[a] = (medido << 3) | (a & 0x07);
+    }
+
+    for (uint32_t i = 0; i < 1024; i++) {
+        copia[i] = mt6835_lut_apply(&lut, raw[ANGULO + i]);
+    }
+
+    int64_t inicio = ahora_ns();
+
+    mt6835_lut_apply_batch(&lut, raw, VUELTA);
+
+    int64_t fin = ahora_ns();
+
+    for (uint32_t i = 0; i < 1024; i++) {
+        distintas += raw[ANGULO + i] != copia[i];
+    }
+
+    printf("%-52s %.2f ns/muestra\n", "batch: tiempo", (double)(fin - inicio) / VUELTA);
+    verificar("batch: igual a mt6835_lut_apply", distintas == 0);
+
+    for (uint32_t a = 0; a < VUELTA; a++) {
+        double antes = distorsion(a * 2 * M_PI / VUELTA);
+        double residuo = fabs((double)mt6835_angle21_diff(mt6835_raw_to_angle21(raw[a]), a));
+
+        estado += (raw[a] & 0x07) != (a & 0x07);
+        suma += residuo * residuo;
+        sumaAntes += antes * antes;
+        maximo = fmax(maximo, residuo);
+        maximoAntes = fmax(maximoAntes, fabs(antes));
+    }
+
+    printf("%-52s rms %.1f max %.0f -> rms %.2f max %.0f cuentas\n", "batch: error antes -> despues",
+           sqrt(sumaAntes / VUELTA), maximoAntes, sqrt(suma / VUELTA), maximo);
+    verificar("batch: residuo en toda la vuelta", maximo <= MAX_RESIDUO);
+    verificar("batch: conserva los bits de estado", estado == 0);
+}
+
+static void probar_cero(void) {
+    static mt6835_sim_t sim;
+    spi_device_handle_t handle;
+    uint32_t angle;
+
+    mt6835_sim_init(&sim);
+    mt6835_set_transport(&mt6835_sim_transport);
+    handle = mt6835_sim_handle(&sim);
+    sim.angle = ANGULO;
+
+    // Sin registrar falla antes de la primera transaccion
+    verificar("set_zero_fine sin attach: ESP_ERR_INVALID_STATE",
+              mt6835_set_zero_fine(&handle, 777777) == ESP_ERR_INVALID_STATE);
+    verificar("set_zero_fine sin attach: no escribe ZERO_POS",
+              sim.transactions == 0 && sim.regs[ZERO_HIGH] == 0 && sim.regs[ZERO_LOW] == 0);
+
+    mt6835_attach(&handle);
+
+    verificar("set_zero_fine: cero a resolucion completa",
+              mt6835_set_zero_fine(&handle, 777777) == ESP_OK && mt6835_get_angle_burst(&handle, &angle) == ESP_OK &&
+              mt6835_raw_to_angle21(angle) == ((ANGULO - 777777) & MT6835_ANGLE21_MASK));
+
+    // 90° = 1023 en ZERO_POS, el resto de 9 bits de 777777 ya no se resta
+    verificar("set_zero: sin el resto de set_zero_fine",
+              mt6835_set_zero(&handle, 90.0) == ESP_OK && mt6835_get_angle_burst(&handle, &angle) == ESP_OK &&
+              mt6835_raw_to_angle21(angle) == ((ANGULO - (1023 << 9)) & MT6835_ANGLE21_MASK));
+
+    // SET_ZERO toma los 12 bits altos del angulo actual: queda solo la parte de 9 bits
+    verificar("set_cur_position_zero: sin el resto de set_zero_fine",
+              mt6835_set_zero_fine(&handle, 777777) == ESP_OK && mt6835_set_cur_position_zero(&handle) == ESP_OK &&
+              mt6835_get_angle_burst(&handle, &angle) == ESP_OK && mt6835_raw_to_angle21(angle) == (ANGULO & 0x1FF));
+}
+
+int main(void) {
+    probar_lut();
+    probar_cero();
+
+    return fallas ? 1 : 0;
+}
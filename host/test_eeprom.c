@@ -0,0 +1,87 @@
+// Grabacion de EEPROM sin bloquear contra el modelo: poll devuelve ESP_ERR_NOT_FINISHED durante la espera,
+// los valores grabados sobreviven a un reinicio del modelo, una imagen sin cambios no se graba y los
+// mensajes de exito van al buffer de eventos
+// Uso: mt6835_test_eeprom (compilado con MT6835_EEPROM_TIME_US chico)
+
+#include <stdio.h>
+#include <unistd.h>
+#include "esp_timer.h"
+#include "mt6835_sim.h"
+
+static int fallas;
+
+static void verificar(const char *nombre, int ok) {
+    printf("%-52s %s\n", nombre, ok ? "ok" : "FALLA");
+    fallas += !ok;
+}
+
+// Evento mas nuevo del buffer de trazas
+static uint8_t ultimo_evento(void) {
+    mt6835_trace_t eventos[MT6835_TRACE_SIZE];
+    uint32_t cantidad = mt6835_trace_read(eventos, MT6835_TRACE_SIZE);
+
+    return (cantidad > 0) ? eventos[cantidad - 1].event : MT6835_EVT_COUNT;
+}
+
+int main(void) {
+    static mt6835_sim_t sim;
+    static mt6835_snapshot_t imagen, leida;
+    spi_device_handle_t handle;
+    uint8_t userId = 0;
+
+    mt6835_sim_init(&sim);
+    mt6835_set_transport(&mt6835_sim_transport);
+    handle = mt6835_sim_handle(&sim);
+
+    verificar("eeprom_start sin attach: ESP_ERR_INVALID_STATE", mt6835_eeprom_start(&handle, NULL) == ESP_ERR_INVALID_STATE);
+
+    mt6835_attach(&handle);
+
+    // 1) Grabacion de los registros actuales: PROG_EEPROM y espera
+    mt6835_set_user_id(&handle, 0x42);
+    mt6835_set_hyst(&handle, 3);
+    mt6835_snapshot_read(&handle, &imagen, 1);
+
+    verificar("start: manda PROG_EEPROM",
+              mt6835_eeprom_start(&handle, NULL) == ESP_OK && sim.eepromWrites == 1 &&
+              ultimo_evento() == MT6835_EVT_PROG_EEPROM);
+    verificar("poll: ESP_ERR_NOT_FINISHED durante la espera", mt6835_eeprom_poll(&handle) == ESP_ERR_NOT_FINISHED);
+    verificar("start: ocupada mientras graba", mt6835_eeprom_start(&handle, NULL) == ESP_ERR_INVALID_STATE);
+
+    usleep(MT6835_EEPROM_TIME_US + 1000);
+
+    verificar("poll: ESP_OK al terminar, evento EEPROM_OK",
+              mt6835_eeprom_poll(&handle) == ESP_OK && ultimo_evento() == MT6835_EVT_EEPROM_OK);
+    verificar("poll: repite el resultado", mt6835_eeprom_poll(&handle) == ESP_OK);
+
+    // 2) Reinicio: los registros volatiles cambiados se pierden y vuelve lo grabado
+    sim.regs[USER_ID] = 0x00;
+    mt6835_sim_power_cycle(&sim);
+    mt6835_cache_invalidate(&handle);
+
+    verificar("power_cycle: USER_ID grabado",
+              mt6835_get_user_id(&handle, &userId) == ESP_OK && userId == 0x42);
+    verificar("power_cycle: snapshot igual a la imagen",
+              mt6835_snapshot_read(&handle, &leida, 1) == ESP_OK && mt6835_snapshot_compare(&leida, &imagen) == 0);
+
+    // 3) Sin escrituras desde la ultima grabacion: no se graba de nuevo
+    verificar("sin cambios: sin PROG_EEPROM, evento EEPROM_SKIP",
+              mt6835_eeprom_start(&handle, NULL) == ESP_OK && sim.eepromWrites == 1 &&
+              ultimo_evento() == MT6835_EVT_EEPROM_SKIP && mt6835_eeprom_poll(&handle) == ESP_OK);
+
+    // 4) Imagen distinta: start la escribe, complete bloquea hasta verificar
+    imagen.regs[USER_ID - USER_ID] = 0x24;
+
+    int64_t inicio = esp_timer_get_time();
+
+    verificar("imagen distinta: start y complete",
+              mt6835_eeprom_start(&handle, &imagen) == ESP_OK && mt6835_eeprom_complete(&handle) == ESP_OK);
+    verificar("complete: espera MT6835_EEPROM_TIME_US",
+              esp_timer_get_time() - inicio >= MT6835_EEPROM_TIME_US && sim.eepromWrites == 2);
+
+    mt6835_sim_power_cycle(&sim);
+    mt6835_cache_invalidate(&handle);
+    verificar("power_cycle: imagen nueva grabada", mt6835_get_user_id(&handle, &userId) == ESP_OK && userId == 0x24);
+
+    return fallas ? 1 : 0;
+}
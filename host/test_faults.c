@@ -0,0 +1,105 @@
+// Contadores de fallas contra el modelo: bits de estado y CRC forzados en el modelo, conteo por tipo,
+// histograma por ventana, envejecimiento de las ventanas y mt6835_reset_faults
+// Uso: mt6835_test_faults (compilado con MT6835_FAULT_WINDOW_SHIFT chico para envejecer en milisegundos)
+
+#include <stdio.h>
+#include <unistd.h>
+#include "mt6835_sim.h"
+
+#define LECTURAS 10
+
+static int fallas;
+
+static void verificar(const char *nombre, int ok) {
+    printf("%-52s %s\n", nombre, ok ? "ok" : "FALLA");
+    fallas += !ok;
+}
+
+static uint32_t histograma(const mt6835_faults_t *faults) {
+    uint32_t suma = 0;
+
+    for (int i = 0; i < MT6835_FAULT_WINDOWS; i++) {
+        suma += faults->histogram[i];
+    }
+
+    return suma;
+}
+
+// Cantidad de llamadas a 'lectura' que retornan 'esperado'
+static int leer(esp_err_t (*lectura)(spi_device_handle_t *, uint32_t *), spi_device_handle_t *handle,
+                int cantidad, esp_err_t esperado) {
+    uint32_t angle;
+    int iguales = 0;
+
+    for (int i = 0; i < cantidad; i++) {
+        iguales += lectura(handle, &angle) == esperado;
+    }
+
+    return iguales;
+}
+
+int main(void) {
+    static mt6835_sim_t sim;
+    spi_device_handle_t handle;
+    mt6835_faults_t faults;
+
+    mt6835_sim_init(&sim);
+    mt6835_set_transport(&mt6835_sim_transport);
+    handle = mt6835_sim_handle(&sim);
+
+    verificar("get_faults sin attach: ESP_ERR_INVALID_STATE", mt6835_get_faults(&handle, &faults) == ESP_ERR_INVALID_STATE);
+    verificar("reset_faults sin attach: ESP_ERR_INVALID_STATE", mt6835_reset_faults(&handle) == ESP_ERR_INVALID_STATE);
+
+    mt6835_attach(&handle);
+    mt6835_reset_faults(&handle);
+
+    // 1) Bits de estado: cada uno en su contador, una muestra con falla por lectura en el histograma
+    sim.status = MT6835_STATUS_OVERSPEED | MT6835_STATUS_UNDERVOLTAGE;
+
+    verificar("burst: los bits de estado no son error",
+              leer(mt6835_get_angle_burst, &handle, LECTURAS, ESP_OK) == LECTURAS);
+    mt6835_get_faults(&handle, &faults);
+    verificar("burst: overspeed y underVoltage, sin weakField",
+              faults.overspeed == LECTURAS && faults.underVoltage == LECTURAS && faults.weakField == 0);
+    verificar("burst: samples e histograma", faults.samples == LECTURAS && histograma(&faults) == LECTURAS);
+
+    // 2) CRC corrupto: ESP_ERR_INVALID_CRC, cuenta en crcFail y en el histograma
+    sim.status = 0;
+    sim.corruptCrc = 1;
+
+    verificar("burst con CRC corrupto: ESP_ERR_INVALID_CRC",
+              leer(mt6835_get_angle_burst, &handle, LECTURAS, ESP_ERR_INVALID_CRC) == LECTURAS);
+    mt6835_get_faults(&handle, &faults);
+    verificar("burst con CRC corrupto: crcFail",
+              faults.crcFail == LECTURAS && faults.overspeed == LECTURAS && faults.samples == 2 * LECTURAS);
+    verificar("burst con CRC corrupto: histograma", histograma(&faults) == 2 * LECTURAS);
+
+    // 3) mt6835_get_angle no verifica CRC: solo cuenta los bits de estado
+    sim.status = MT6835_STATUS_WEAK_FIELD;
+
+    verificar("get_angle con CRC corrupto: ESP_OK", leer(mt6835_get_angle, &handle, LECTURAS, ESP_OK) == LECTURAS);
+    mt6835_get_faults(&handle, &faults);
+    verificar("get_angle: weakField sin crcFail", faults.weakField == LECTURAS && faults.crcFail == LECTURAS);
+
+    // 4) Lecturas sin falla: cuentan como muestra pero no en el histograma
+    sim.status = 0;
+    sim.corruptCrc = 0;
+    leer(mt6835_get_angle_burst, &handle, LECTURAS, ESP_OK);
+    mt6835_get_faults(&handle, &faults);
+    verificar("sin falla: samples sin histograma", faults.samples == 4 * LECTURAS && histograma(&faults) == 3 * LECTURAS);
+
+    // 5) Pasadas todas las ventanas el histograma queda en cero, los totales no
+    usleep(((MT6835_FAULT_WINDOWS + 1) << MT6835_FAULT_WINDOW_SHIFT));
+    mt6835_get_faults(&handle, &faults);
+    verificar("ventanas viejas: histograma en cero", histograma(&faults) == 0);
+    verificar("ventanas viejas: conserva los totales", faults.overspeed == LECTURAS && faults.crcFail == LECTURAS);
+
+    // 6) reset_faults borra todo
+    mt6835_reset_faults(&handle);
+    mt6835_get_faults(&handle, &faults);
+    verificar("reset_faults: contadores en cero",
+              faults.samples == 0 && faults.overspeed == 0 && faults.weakField == 0 && faults.underVoltage == 0 &&
+              faults.crcFail == 0 && histograma(&faults) == 0);
+
+    return fallas ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+// Estimador hibrido con un contador de cuadratura simulado (16 bits, con desborde)
+// Compara el error contra usar solo el ultimo angulo SPI y verifica que se detecten las cuentas perdidas
+// Uso: mt6835_test_hybrid
+
+#include <stdio.h>
+#include <math.h>
+#include "mt6835_track.h"
+#include "mt6835_angle.h"
+
+#define ABZ_RES     4096
+#define MUESTRAS    200000
+#define UMBRAL      256         // Cuentas de 21 bits, 2 cuentas de cuadratura
+#define CUADRATURA  (2097152 / (4 * ABZ_RES))
+
+static int64_t verdad;          // Posicion real, cuentas de 21 bits multivuelta
+static int32_t perdidas;        // Cuentas de cuadratura que el contador no vio
+
+static int32_t leer_contador(void *arg) {
+    int64_t cuentas = (verdad * 4 * ABZ_RES) >> 21;
+
+    return (uint16_t)(cuentas - perdidas);
+}
+
+typedef struct {
+    const char *nombre;
+    uint32_t anclaje;           // Muestras entre lecturas SPI
+    int32_t ganancia;           // Q16
+    uint32_t periodoFalla;      // Muestras entre cuentas perdidas, 0 = sin fallas
+    double maxHibrido;          // Cuentas de 21 bits
+} caso_t;
+
+static const caso_t casos[] = {
+    { "sin fallas, SPI 1/10", 10, 65536, 0, 2 * CUADRATURA },
+    { "3 cuentas perdidas, SPI 1/10", 10, 65536, 5000, 5 * CUADRATURA },
+    { "3 cuentas perdidas, g 0.25", 10, 16384, 5000, 5 * CUADRATURA },
+    { "3 cuentas perdidas, SPI 1/20", 20, 65536, 5000, 5 * CUADRATURA },
+};
+
+int main(void) {
+    int fallas = 0;
+
+    printf("%-30s %12s %12s %12s %10s\n", "caso", "hibrido rms", "hibrido max", "solo SPI rms", "derivas");
+
+    for (size_t c = 0; c < sizeof(casos) / sizeof(casos[0]); c++) {
+        const caso_t *caso = &casos[c];
+        mt6835_counter_t contador = { .read = leer_contador, .bits = 16 };
+        mt6835_hybrid_t hyb;
+        double suma = 0, maximo = 0, sumaSpi = 0;
+        int64_t ultimoSpi = 0;
+        uint32_t derivas = 0, inyectadas = 0, n = 0;
+
+        verdad = 123456;
+        perdidas = 0;
+        mt6835_hybrid_init(&hyb, &contador, ABZ_RES, caso->ganancia, UMBRAL);
+
+        for (uint32_t i = 0; i < MUESTRAS; i++) {
+            // Velocidad variable, unas 3000 cuentas por muestra
+            verdad += 3000 + (int32_t)(1000 * sin(i * 1e-3));
+
+            if (caso->periodoFalla && i % caso->periodoFalla == caso->periodoFalla / 2) {
+                perdidas += 3;
+                inyectadas++;
+            }
+
+            if (i % caso->anclaje == 0) {
+                derivas += mt6835_hybrid_anchor(&hyb, (uint32_t)(verdad & 0x1FFFFF) << 3);
+                ultimoSpi = verdad;
+            } else {
+                mt6835_hybrid_update(&hyb);
+            }
+
+            if (i < 1000) {
+                continue;
+            }
+
+            double error = mt6835_angle21_diff(mt6835_hybrid_angle(&hyb), verdad & 0x1FFFFF);
+            double errorSpi = (double)(verdad - ultimoSpi);
+
+            suma += error * error;
+            sumaSpi += errorSpi * errorSpi;
+            maximo = fmax(maximo, fabs(error));
+            n++;
+        }
+
+        // Cada falla inyectada tiene que aparecer como deriva en el anclaje siguiente
+        int falla = maximo > caso->maxHibrido || derivas < inyectadas;
+
+        printf("%-30s %12.1f %12.0f %12.0f %5lu/%-4lu%s\n", caso->nombre, sqrt(suma / n), maximo, sqrt(sumaSpi / n),
+               (unsigned long)derivas, (unsigned long)inyectadas, falla ? "  FALLA" : "");
+        fallas += falla;
+    }
+
+    return fallas ? 1 : 0;
+}
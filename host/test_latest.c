@@ -0,0 +1,128 @@
+// Ultima muestra publicada: latest_acquire publica el fin de la transaccion, conteo de muestras salteadas y
+// repetidas por lector, y un escritor y un lector en hilos distintos sin copias cortadas
+// Uso: mt6835_test_latest
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include "esp_timer.h"
+#include "mt6835_sim.h"
+
+#define PUBLICACIONES 200000
+
+static mt6835_sim_t sim;
+static spi_device_handle_t handle;
+static _Atomic int terminado;
+static int fallas;
+
+static void verificar(const char *nombre, int ok) {
+    printf("%-52s %s\n", nombre, ok ? "ok" : "FALLA");
+    fallas += !ok;
+}
+
+// raw distinto para cada muestra y derivable del numero de muestra, para detectar mezclas de dos publicaciones
+static uint32_t raw_de(uint32_t n) {
+    return (n * 2654435761u) & 0xFFFFFF;
+}
+
+static void *escritor(void *arg) {
+    // La muestra n lleva timestamp n: seq, timestamp y raw tienen que llegar juntos
+    for (uint32_t n = 1; n <= PUBLICACIONES; n++) {
+        mt6835_latest_publish(&handle, raw_de(n), n);
+
+        if ((n & 0xFF) == 0) {
+            sched_yield();
+        }
+    }
+
+    atomic_store(&terminado, 1);
+
+    return NULL;
+}
+
+int main(void) {
+    mt6835_latest_t muestra;
+    mt6835_subscriber_t sub = { 0 };
+    mt6835_timing_t timing;
+
+    mt6835_sim_init(&sim);
+    mt6835_set_transport(&mt6835_sim_transport);
+    handle = mt6835_sim_handle(&sim);
+
+    verificar("acquire sin attach: sin transacciones",
+              mt6835_latest_acquire(&handle) == ESP_ERR_INVALID_STATE && sim.transactions == 0);
+
+    mt6835_attach(&handle);
+
+    verificar("read antes de publicar: ESP_ERR_INVALID_STATE",
+              mt6835_latest_read(&handle, &sub, &muestra) == ESP_ERR_INVALID_STATE);
+
+    // 1) acquire: la marca de tiempo es la de la transaccion, la misma que ve mt6835_get_timing
+    sim.angle = 1234567;
+
+    int64_t antes = esp_timer_get_time();
+
+    mt6835_latest_acquire(&handle);
+    mt6835_latest_read(&handle, NULL, &muestra);
+    mt6835_get_timing(&handle, &timing);
+
+    verificar("acquire: timestamp = fin de la transaccion",
+              muestra.timestamp == timing.fin && muestra.timestamp >= antes && timing.fin >= timing.inicio);
+    verificar("acquire: angulo del modelo", mt6835_raw_to_angle21(muestra.raw) == 1234567 && muestra.seq == 1);
+
+    // 2) Un lector: repetidas sin muestra nueva, salteadas cuando se publica mas de una entre lecturas
+    mt6835_latest_read(&handle, &sub, &muestra);
+
+    verificar("lector: segunda lectura repetida",
+              mt6835_latest_read(&handle, &sub, &muestra) == ESP_ERR_NOT_FINISHED && sub.repetidas == 1);
+
+    for (int i = 0; i < 3; i++) {
+        mt6835_latest_publish(&handle, raw_de(i), i);
+    }
+
+    verificar("lector: dos salteadas de tres publicadas",
+              mt6835_latest_read(&handle, &sub, &muestra) == ESP_OK && sub.saltadas == 2 && sub.seq == 4 &&
+              muestra.raw == raw_de(2));
+
+    // 3) Escritor y lector en hilos distintos
+    pthread_t hilo;
+    mt6835_subscriber_t lector = { 0 };
+    uint32_t leidas = 0, repetidas = 0, timeouts = 0, cortadas = 0, base;
+
+    // Los numeros de muestra siguen desde la ultima publicacion
+    mt6835_latest_read(&handle, NULL, &muestra);
+    base = muestra.seq;
+    lector.seq = base;
+
+    pthread_create(&hilo, NULL, escritor, NULL);
+
+    while (!atomic_load(&terminado)) {
+        esp_err_t error = mt6835_latest_read(&handle, &lector, &muestra);
+
+        if (error == ESP_ERR_NOT_FINISHED) {
+            repetidas++;
+        } else if (error == ESP_ERR_TIMEOUT) {
+            timeouts++;
+        } else {
+            uint32_t n = muestra.timestamp;
+
+            cortadas += muestra.seq != base + n || muestra.raw != raw_de(n) || muestra.status != (raw_de(n) & 0x07);
+            leidas++;
+        }
+
+        if (((leidas + repetidas) & 0xFF) == 0) {
+            sched_yield();
+        }
+    }
+
+    pthread_join(hilo, NULL);
+
+    printf("%-52s %lu leidas, %lu salteadas, %lu repetidas, %lu sin copia\n", "hilos:",
+           (unsigned long)leidas, (unsigned long)lector.saltadas, (unsigned long)repetidas, (unsigned long)timeouts);
+    verificar("hilos: sin copias cortadas", cortadas == 0 && leidas > 0);
+    verificar("hilos: leidas + salteadas = publicadas vistas", leidas + lector.saltadas == lector.seq - base);
+    verificar("hilos: repetidas contadas en el lector", lector.repetidas == repetidas);
+    verificar("hilos: la ultima vista <= la ultima publicada", lector.seq <= base + PUBLICACIONES);
+
+    return fallas ? 1 : 0;
+}
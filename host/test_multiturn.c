@@ -0,0 +1,141 @@
+// Acumulador multivuelta: vueltas hacia adelante y hacia atras contra la posicion exacta, rechazo de saltos
+// mayores a maxStep y un lector en otro hilo que no puede ver posiciones cortadas por el seqlock
+// Uso: mt6835_test_multiturn
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include "mt6835_track.h"
+
+#define VUELTA      2097152
+#define PASO_MAX    1048575     // Mayor salto sin ambiguedad, media vuelta menos una cuenta
+#define MUESTRAS    5600000     // Unas 2.4 millones de vueltas a PASO_MAX
+#define PASO_HILOS  1000003
+
+static int fallas;
+
+static void verificar(const char *nombre, int ok) {
+    printf("%-52s %s\n", nombre, ok ? "ok" : "FALLA");
+    fallas += !ok;
+}
+
+static uint32_t raw(int64_t posicion) {
+    return ((uint32_t)posicion & (VUELTA - 1)) << 3;
+}
+
+// Recorre MUESTRAS pasos de 'paso' cuentas desde 'inicio' y compara con la posicion exacta
+static int recorrer(int64_t inicio, int32_t paso) {
+    mt6835_multiturn_t mt;
+    int64_t real = inicio, posicion, vueltas;
+    int errores = 0;
+
+    mt6835_multiturn_init(&mt, 0);
+    mt6835_multiturn_update(&mt, raw(inicio));
+
+    // La posicion arranca en el angulo de la primera muestra
+    real = inicio & (VUELTA - 1);
+
+    for (uint32_t i = 0; i < MUESTRAS; i++) {
+        real += paso;
+        errores += mt6835_multiturn_update(&mt, raw(real));
+    }
+
+    errores += mt6835_multiturn_position(&mt, &posicion) != 0 || posicion != real;
+    errores += mt6835_multiturn_turns(&mt, &vueltas) != 0 || vueltas != (real >> 21);
+    errores += mt6835_multiturn_missed(&mt) != 0;
+
+    return errores;
+}
+
+static mt6835_multiturn_t compartido;
+static _Atomic int terminado;
+
+static void *escritor(void *arg) {
+    int64_t real = 0;
+
+    for (uint32_t i = 0; i < MUESTRAS / 4; i++) {
+        real += PASO_HILOS;
+        mt6835_multiturn_update(&compartido, raw(real));
+
+        if ((i & 0xFF) == 0) {
+            sched_yield();
+        }
+    }
+
+    atomic_store(&terminado, 1);
+
+    return NULL;
+}
+
+int main(void) {
+    mt6835_multiturn_t mt;
+    int64_t posicion, vueltas;
+
+    // 1) Vueltas completas en los dos sentidos, mas alla de 2^32 cuentas
+    verificar("adelante: 2.4M vueltas a media vuelta por muestra", recorrer(12345, PASO_MAX) == 0);
+    verificar("atras: 2.4M vueltas a media vuelta por muestra", recorrer(12345, -PASO_MAX) == 0);
+    verificar("adelante y atras a paso chico", recorrer(VUELTA - 10, 777) == 0 && recorrer(10, -777) == 0);
+
+    // 2) Cruce del cero hacia atras: la posicion pasa a negativa y las vueltas son el piso
+    mt6835_multiturn_init(&mt, 0);
+    mt6835_multiturn_update(&mt, raw(5));
+    mt6835_multiturn_update(&mt, raw(-1));
+    mt6835_multiturn_position(&mt, &posicion);
+    mt6835_multiturn_turns(&mt, &vueltas);
+    verificar("cero hacia atras: posicion -1, vuelta -1", posicion == -1 && vueltas == -1);
+
+    mt6835_multiturn_update(&mt, raw(-1000000));
+    mt6835_multiturn_update(&mt, raw(-2000000));
+    mt6835_multiturn_update(&mt, raw(-VUELTA - 1));
+    mt6835_multiturn_position(&mt, &posicion);
+    mt6835_multiturn_turns(&mt, &vueltas);
+    verificar("cero hacia atras: una vuelta mas, vuelta -2", posicion == -VUELTA - 1 && vueltas == -2);
+
+    // 3) maxStep: el salto mayor se cuenta como muestra perdida pero se acumula igual
+    mt6835_multiturn_init(&mt, 1000);
+    mt6835_multiturn_update(&mt, raw(0));
+
+    int perdida = mt6835_multiturn_update(&mt, raw(1000));
+
+    perdida += mt6835_multiturn_update(&mt, raw(-1000)) * 10;
+    perdida += mt6835_multiturn_update(&mt, raw(-2001)) * 100;
+    mt6835_multiturn_position(&mt, &posicion);
+    verificar("maxStep: solo el salto de 2000 y el de 1001", perdida == 110 && mt6835_multiturn_missed(&mt) == 2);
+    verificar("maxStep: la posicion incluye los saltos", posicion == -2001);
+
+    mt6835_multiturn_init(&mt, 0);
+    verificar("maxStep 0: media vuelta", mt.maxStep == (1 << 20));
+
+    // 4) Lector concurrente: toda posicion leida es multiplo de PASO_HILOS y no retrocede
+    pthread_t hilo;
+    int64_t anterior = 0;
+    uint32_t lecturas = 0, cortadas = 0, reintentos = 0;
+
+    mt6835_multiturn_init(&compartido, 0);
+    mt6835_multiturn_update(&compartido, raw(0));
+    pthread_create(&hilo, NULL, escritor, NULL);
+
+    while (!atomic_load(&terminado)) {
+        if (mt6835_multiturn_position(&compartido, &posicion) != 0) {
+            reintentos++;
+            continue;
+        }
+
+        cortadas += posicion % PASO_HILOS != 0 || posicion < anterior;
+        anterior = posicion;
+        lecturas++;
+
+        if ((lecturas & 0xFF) == 0) {
+            sched_yield();
+        }
+    }
+
+    pthread_join(hilo, NULL);
+    mt6835_multiturn_position(&compartido, &posicion);
+
+    printf("%-52s %lu lecturas, %lu sin copia consistente\n", "lector concurrente:", (unsigned long)lecturas, (unsigned long)reintentos);
+    verificar("lector concurrente: sin posiciones cortadas", cortadas == 0 && lecturas > 0);
+    verificar("lector concurrente: posicion final", posicion == (int64_t)PASO_HILOS * (MUESTRAS / 4));
+
+    return fallas ? 1 : 0;
+}
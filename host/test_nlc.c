@@ -0,0 +1,87 @@
+// Calibracion NLC con MT6835_NLC_LAYOUT 1: captura sintetica a velocidad constante con una distorsion
+// conocida, la tabla tiene que ser la distorsion con signo opuesto. Despues se escribe en el modelo,
+// se relee y se habilita NLC
+// Uso: mt6835_test_nlc
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "mt6835_sim.h"
+
+#define MUESTRAS    20000
+#define VUELTAS     1.3         // No entera: calibrate tiene que recortar a vueltas completas
+#define A1          800.0       // Cuentas, primer armonico (seno)
+#define A2          -300.0      // Cuentas, segundo armonico (coseno)
+#define TOLERANCIA  10          // Cuentas
+
+static uint32_t raw[MUESTRAS];
+static int fallas;
+
+static void verificar(const char *nombre, int ok) {
+    printf("%-52s %s\n", nombre, ok ? "ok" : "FALLA");
+    fallas += !ok;
+}
+
+static double distorsion(double theta) {
+    return A1 * sin(theta) + A2 * cos(2 * theta);
+}
+
+static int32_t punto(const uint8_t *tabla, int j) {
+    int32_t valor = ((int32_t)tabla[3*j] << 16) | ((int32_t)tabla[3*j + 1] << 8) | tabla[3*j + 2];
+
+    // 24 bits con signo
+    return (valor << 8) >> 8;
+}
+
+int main(void) {
+    static mt6835_sim_t sim;
+    spi_device_handle_t handle;
+    uint8_t tabla[MT6835_NLC_SIZE] = { 0 }, leida[MT6835_NLC_SIZE];
+    int32_t maxError = 0;
+    uint32_t distintos = 0;
+
+    // 1) Captura: angulo real a velocidad constante mas la distorsion del sensor
+    for (uint32_t i = 0; i < MUESTRAS; i++) {
+        double real = 12345.0 + VUELTAS * 2097152.0 * i / MUESTRAS;
+        double theta = real * 2 * M_PI / 2097152.0;
+
+        raw[i] = ((uint32_t)llround(real + distorsion(theta)) & MT6835_ANGLE21_MASK) << 3;
+    }
+
+    verificar("calibrate: armonicos fuera de rango", mt6835_nlc_calibrate(raw, MUESTRAS, 0, tabla) == ESP_ERR_INVALID_ARG &&
+              mt6835_nlc_calibrate(raw, MUESTRAS, MT6835_NLC_MAX_HARMONICS + 1, tabla) == ESP_ERR_INVALID_ARG);
+    verificar("calibrate: menos de una vuelta", mt6835_nlc_calibrate(raw, MUESTRAS / 2, 2, tabla) == ESP_ERR_INVALID_SIZE);
+    verificar("calibrate: ESP_OK con la captura completa", mt6835_nlc_calibrate(raw, MUESTRAS, 4, tabla) == ESP_OK);
+
+    for (int j = 0; j < MT6835_NLC_POINTS; j++) {
+        int32_t esperado = -(int32_t)lround(distorsion(j * 2 * M_PI / MT6835_NLC_POINTS));
+        int32_t error = punto(tabla, j) - esperado;
+
+        maxError = (abs(error) > maxError) ? abs(error) : maxError;
+    }
+
+    printf("%-52s %ld cuentas\n", "calibrate: error maximo de la tabla", (long)maxError);
+    verificar("calibrate: tabla = -distorsion", maxError <= TOLERANCIA);
+
+    // 2) Escritura contra el modelo: una lectura de la tabla y una escritura por byte distinto
+    mt6835_sim_init(&sim);
+    mt6835_set_transport(&mt6835_sim_transport);
+    handle = mt6835_sim_handle(&sim);
+    mt6835_attach(&handle);
+
+    for (int i = 0; i < MT6835_NLC_SIZE; i++) {
+        distintos += tabla[i] != 0;
+    }
+
+    verificar("write: ESP_OK", mt6835_nlc_write(&handle, tabla) == ESP_OK);
+    verificar("write: solo los bytes distintos", sim.transactions == 1 + distintos);
+    verificar("read: relee la tabla escrita", mt6835_nlc_read(&handle, leida) == ESP_OK && memcmp(leida, tabla, sizeof(tabla)) == 0);
+
+    mt6835_sim_reset_stats(&sim);
+
+    verificar("write: la misma tabla no escribe nada", mt6835_nlc_write(&handle, tabla) == ESP_OK && sim.transactions == 1);
+    verificar("enable: NLC_EN en PWM_CONF", mt6835_nlc_enable(&handle, 1) == ESP_OK && (sim.regs[PWM_CONF] & 0x20));
+
+    return fallas ? 1 : 0;
+}
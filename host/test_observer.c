@@ -0,0 +1,105 @@
+// Observador contra trayectorias sinteticas con ruido gaussiano de medicion
+// Reporta error de angulo y velocidad en regimen y falla si supera los limites de cada trayectoria
+// Uso: mt6835_test_observer
+
+#include <stdio.h>
+#include <math.h>
+#include "mt6835_track.h"
+#include "mt6835_angle.h"
+
+#define FS          20000       // Hz
+#define BW          200         // Hz
+#define MUESTRAS    40000
+#define TRANSITORIO 8000        // Muestras descartadas al inicio
+#define RUIDO       20.0        // Cuentas RMS
+#define VUELTA      2097152.0   // Cuentas de 21 bits por vuelta
+
+typedef struct {
+    const char *nombre;
+    void (*trayectoria)(double t, double *angulo, double *velocidad);   // Vueltas, vueltas/s
+    double maxAngulo;           // Cuentas
+    double maxVelocidad;        // Vueltas/s
+} caso_t;
+
+static void constante(double t, double *angulo, double *velocidad) {
+    *angulo = 50 * t;
+    *velocidad = 50;
+}
+
+// 0 a 100 vueltas/s en 1 s y despues constante
+static void rampa(double t, double *angulo, double *velocidad) {
+    double tr = (t < 1) ? t : 1;
+
+    *angulo = 50 * tr * tr + ((t > 1) ? 100 * (t - 1) : 0);
+    *velocidad = (t < 1) ? 100 * t : 100;
+}
+
+// Oscilacion de 5 Hz y un cuarto de vuelta
+static void seno(double t, double *angulo, double *velocidad) {
+    *angulo = 0.25 * sin(2 * M_PI * 5 * t);
+    *velocidad = 0.25 * 2 * M_PI * 5 * cos(2 * M_PI * 5 * t);
+}
+
+static const caso_t casos[] = {
+    { "constante 50 vueltas/s", constante, 64, 0.05 },
+    { "rampa 0-100 vueltas/s", rampa, 64, 0.1 },       // Escalon de aceleracion en t = 1 s
+    { "seno 5 Hz 0.25 vueltas", seno, 64, 0.05 },
+};
+
+// Gaussiana reproducible (Box-Muller sobre un LCG)
+static uint32_t semilla = 1;
+
+static double uniforme(void) {
+    semilla = semilla * 1664525 + 1013904223;
+    return (semilla + 1.0) / 4294967297.0;
+}
+
+static double gauss(void) {
+    return sqrt(-2 * log(uniforme())) * cos(2 * M_PI * uniforme());
+}
+
+int main(void) {
+    int fallas = 0;
+
+    printf("%-26s %12s %12s %14s\n", "trayectoria", "max cuentas", "rms cuentas", "max vueltas/s");
+
+    for (size_t c = 0; c < sizeof(casos) / sizeof(casos[0]); c++) {
+        const caso_t *caso = &casos[c];
+        mt6835_observer_t obs;
+        double maxAngulo = 0, maxVelocidad = 0, suma = 0;
+        int n = 0;
+
+        semilla = 1;
+        mt6835_observer_init(&obs, BW, FS);
+
+        for (int i = 0; i < MUESTRAS; i++) {
+            double angulo, velocidad;
+
+            caso->trayectoria((double)i / FS, &angulo, &velocidad);
+
+            uint32_t medido = (uint32_t)llround(angulo * VUELTA + RUIDO * gauss()) & 0x1FFFFF;
+
+            mt6835_observer_update(&obs, medido << 3);
+
+            if (i < TRANSITORIO) {
+                continue;
+            }
+
+            uint32_t real = (uint32_t)llround(angulo * VUELTA) & 0x1FFFFF;
+            double error = mt6835_angle21_diff(mt6835_observer_angle(&obs), real);
+            double errorVelocidad = fabs(mt6835_observer_velocity(&obs) / VUELTA - velocidad);
+
+            maxAngulo = fmax(maxAngulo, fabs(error));
+            maxVelocidad = fmax(maxVelocidad, errorVelocidad);
+            suma += error * error;
+            n++;
+        }
+
+        int falla = maxAngulo > caso->maxAngulo || maxVelocidad > caso->maxVelocidad;
+
+        printf("%-26s %12.1f %12.1f %14.4f%s\n", caso->nombre, maxAngulo, sqrt(suma / n), maxVelocidad, falla ? "  FALLA" : "");
+        fallas += falla;
+    }
+
+    return fallas ? 1 : 0;
+}
@@ -0,0 +1,121 @@
+// Scheduler de varios ejes con fallas inyectadas en el transporte: los ejes que fallan quedan marcados en
+// muestra.error y el skew se calcula solo con los que completaron la transaccion
+// Uso: mt6835_test_sched
+
+#include <stdio.h>
+#include "mt6835_sim.h"
+
+#define EJES 3
+
+static mt6835_sim_t sims[EJES];
+static spi_device_handle_t handles[EJES];
+static int fallaEncolar = -1;       // Eje cuyo queue_trans falla, -1 = ninguno
+static int fallaResultado = -1;     // Eje cuyo get_trans_result falla, -1 = ninguno
+static int fallas;
+
+static void verificar(const char *nombre, int ok) {
+    printf("%-52s %s\n", nombre, ok ? "ok" : "FALLA");
+    fallas += !ok;
+}
+
+static int eje(spi_device_handle_t handle) {
+    for (int i = 0; i < EJES; i++) {
+        if (handles[i] == handle) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static esp_err_t queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t espera) {
+    if (eje(handle) == fallaEncolar) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    return mt6835_sim_transport.queue_trans(handle, trans, espera);
+}
+
+// Retira la transaccion del modelo igual, como un driver que la completo con error
+static esp_err_t get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t espera) {
+    esp_err_t error = mt6835_sim_transport.get_trans_result(handle, trans, espera);
+
+    return (error == ESP_OK && eje(handle) == fallaResultado) ? ESP_FAIL : error;
+}
+
+static int sin_pendientes(void) {
+    int vacias = 1;
+
+    for (int i = 0; i < EJES; i++) {
+        vacias &= sims[i].queueHead == sims[i].queueTail;
+    }
+
+    return vacias;
+}
+
+int main(void) {
+    static const mt6835_transport_t transporte = {
+        .transmit = NULL,
+        .polling_transmit = NULL,
+        .queue_trans = queue_trans,
+        .get_trans_result = get_trans_result,
+        .acquire_bus = NULL,
+        .release_bus = NULL
+    };
+    mt6835_sched_t sched;
+    mt6835_sched_sample_t muestra;
+    esp_err_t error;
+
+    mt6835_set_transport(&transporte);
+    mt6835_sched_init(&sched);
+
+    for (int i = 0; i < EJES; i++) {
+        mt6835_sim_init(&sims[i]);
+        sims[i].angle = 100000 * (i + 1);
+        handles[i] = mt6835_sim_handle(&sims[i]);
+        mt6835_attach(&handles[i]);
+        mt6835_sched_add(&sched, &handles[i]);
+    }
+
+    // 1) Sin fallas
+    error = mt6835_sched_read(&sched, &muestra);
+
+    verificar("sin fallas: ESP_OK y error en 0", error == ESP_OK && muestra.error == 0 && muestra.crcFail == 0);
+    verificar("sin fallas: angulo de cada eje",
+              mt6835_raw_to_angle21(muestra.raw[0]) == 100000 && mt6835_raw_to_angle21(muestra.raw[1]) == 200000 &&
+              mt6835_raw_to_angle21(muestra.raw[2]) == 300000);
+    verificar("sin fallas: skew referido al eje 0",
+              muestra.skew[0] == 0 && muestra.skew[2] >= muestra.skew[1] && muestra.skew[1] >= 0 &&
+              muestra.maxSkew == muestra.skew[2]);
+
+    // 2) Falla el resultado del eje del medio
+    fallaResultado = 1;
+    error = mt6835_sched_read(&sched, &muestra);
+
+    verificar("resultado eje 1: ESP_FAIL y bit 1 en error", error == ESP_FAIL && muestra.error == 0x2);
+    verificar("resultado eje 1: raw y timestamp en 0", muestra.raw[1] == 0 && muestra.timestamp[1] == 0 && muestra.skew[1] == 0);
+    verificar("resultado eje 1: los otros ejes son validos",
+              mt6835_raw_to_angle21(muestra.raw[0]) == 100000 && mt6835_raw_to_angle21(muestra.raw[2]) == 300000 &&
+              muestra.maxSkew == muestra.timestamp[2] - muestra.timestamp[0]);
+    verificar("resultado eje 1: cola vacia", sin_pendientes());
+
+    // 3) Falla el primer eje: la referencia del skew pasa a ser el eje 1
+    fallaResultado = 0;
+    error = mt6835_sched_read(&sched, &muestra);
+
+    verificar("resultado eje 0: skew referido al eje 1",
+              error == ESP_FAIL && muestra.error == 0x1 && muestra.skew[1] == 0 &&
+              muestra.skew[2] == muestra.timestamp[2] - muestra.timestamp[1] && muestra.maxSkew == muestra.skew[2]);
+
+    // 4) No se puede encolar el ultimo eje: se retiran los encolados y se retorna el error de encolado
+    fallaResultado = -1;
+    fallaEncolar = 2;
+    error = mt6835_sched_read(&sched, &muestra);
+
+    verificar("encolar eje 2: error de encolado y bit 2 en error", error == ESP_ERR_TIMEOUT && muestra.error == 0x4);
+    verificar("encolar eje 2: ejes 0 y 1 validos y cola vacia",
+              mt6835_raw_to_angle21(muestra.raw[0]) == 100000 && mt6835_raw_to_angle21(muestra.raw[1]) == 200000 &&
+              muestra.raw[2] == 0 && sin_pendientes());
+
+    return fallas ? 1 : 0;
+}
@@ -0,0 +1,101 @@
+// Seno y coseno Q15 contra sinf/cosf en toda la resolucion que usa mt6835_sincos_q15 (2^24 angulos Q32),
+// y angulo electrico de mt6835_foc_compute / mt6835_get_foc contra mech * polePairs + elecOffset
+// Uso: mt6835_test_sincos
+// El barrido es exhaustivo: la interpolacion no usa los 8 bits bajos del angulo Q32
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mt6835_sim.h"
+
+#define PASO_Q32    256         // La interpolacion ignora los 8 bits bajos del angulo Q32
+#define MAX_ERROR   4           // LSB Q15, lo que promete mt6835_angle.h
+#define VUELTA      2097152
+
+static int fallas;
+
+static void verificar(const char *nombre, int ok) {
+    printf("%-52s %s\n", nombre, ok ? "ok" : "FALLA");
+    fallas += !ok;
+}
+
+static int32_t referencia(float valor) {
+    return (int32_t)lroundf(valor * 32767.0f);
+}
+
+static void probar_sincos(void) {
+    int32_t maxSeno = 0, maxCoseno = 0;
+
+    for (uint64_t q = 0; q < (1ULL << 32); q += PASO_Q32) {
+        float theta = (float)((double)q * 2 * M_PI / 4294967296.0);
+        int16_t seno, coseno;
+
+        mt6835_sincos_q15((mt6835_turns_q32_t)q, &seno, &coseno);
+
+        int32_t errorSeno = abs(seno - referencia(sinf(theta)));
+        int32_t errorCoseno = abs(coseno - referencia(cosf(theta)));
+
+        maxSeno = errorSeno > maxSeno ? errorSeno : maxSeno;
+        maxCoseno = errorCoseno > maxCoseno ? errorCoseno : maxCoseno;
+    }
+
+    printf("%-52s seno %ld coseno %ld LSB\n", "sincos_q15: error maximo en 2^24 angulos", (long)maxSeno, (long)maxCoseno);
+    verificar("sincos_q15: seno <= 4 LSB", maxSeno <= MAX_ERROR);
+    verificar("sincos_q15: coseno <= 4 LSB", maxCoseno <= MAX_ERROR);
+}
+
+static void probar_foc(void) {
+    static const uint8_t pares[] = { 1, 4, 7, 21 };
+    static const mt6835_turns_q32_t offsets[] = { 0, 0x40000000, 0xDEADBEEF };
+    uint32_t errores = 0;
+
+    for (int p = 0; p < 4; p++) {
+        for (int o = 0; o < 3; o++) {
+            mt6835_foc_t foc = { .polePairs = pares[p], .elecOffset = offsets[o] };
+
+            for (uint32_t mech = 0; mech < VUELTA; mech += 3) {
+                mt6835_foc_sample_t muestra;
+                int16_t seno, coseno;
+                // Vuelta electrica = overflow de 32 bits de mech << 11 * polePairs
+                uint32_t elec = (uint32_t)(((uint64_t)mech << 11) * pares[p] + offsets[o]);
+
+                mt6835_foc_compute(&foc, (mech << 3) | (mech & 0x07), &muestra);
+                mt6835_sincos_q15(elec, &seno, &coseno);
+
+                errores += muestra.mech != mech || muestra.status != (mech & 0x07) || muestra.elec != elec;
+                errores += muestra.sin != seno || muestra.cos != coseno;
+            }
+        }
+    }
+
+    verificar("foc_compute: elec = mech * polePairs + elecOffset", errores == 0);
+}
+
+static void probar_get_foc(void) {
+    static mt6835_sim_t sim;
+    spi_device_handle_t handle;
+    mt6835_foc_t foc = { .polePairs = 7, .elecOffset = 0x12345678 };
+    mt6835_foc_sample_t muestra, esperada;
+
+    mt6835_sim_init(&sim);
+    mt6835_set_transport(&mt6835_sim_transport);
+    handle = mt6835_sim_handle(&sim);
+    mt6835_attach(&handle);
+    sim.angle = 1234567;
+
+    mt6835_foc_compute(&foc, (uint32_t)sim.angle << 3, &esperada);
+
+    verificar("get_foc: una lectura en rafaga del modelo",
+              mt6835_get_foc(&handle, &foc, &muestra) == ESP_OK && sim.transactions == 1);
+    verificar("get_foc: igual a foc_compute de la lectura",
+              muestra.mech == esperada.mech && muestra.elec == esperada.elec &&
+              muestra.sin == esperada.sin && muestra.cos == esperada.cos);
+}
+
+int main(void) {
+    probar_sincos();
+    probar_foc();
+    probar_get_foc();
+
+    return fallas ? 1 : 0;
+}
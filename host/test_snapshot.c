@@ -0,0 +1,89 @@
+// Snapshots de configuracion contra el modelo: un registro cambiado aparece como exactamente una diferencia,
+// los registros de angulo no cuentan, la tabla NLC solo se compara si esta en las dos imagenes, y
+// restore escribe solo lo distinto
+// Uso: mt6835_test_snapshot
+
+#include <stdio.h>
+#include "mt6835_sim.h"
+
+static int fallas;
+
+static void verificar(const char *nombre, int ok) {
+    printf("%-52s %s\n", nombre, ok ? "ok" : "FALLA");
+    fallas += !ok;
+}
+
+// Indice del unico registro distinto entre a y b, -1 si no hay exactamente uno
+static int distinto(const mt6835_snapshot_t *a, const mt6835_snapshot_t *b) {
+    int indice = -1, cantidad = 0;
+
+    for (int i = 0; i < MT6835_CONF_SIZE; i++) {
+        if (a->regs[i] != b->regs[i]) {
+            indice = i;
+            cantidad++;
+        }
+    }
+
+    return (cantidad == 1) ? indice : -1;
+}
+
+int main(void) {
+    static mt6835_sim_t sim;
+    static mt6835_snapshot_t original, cambiado, sinNlc, leido;
+    spi_device_handle_t handle;
+
+    mt6835_sim_init(&sim);
+    mt6835_set_transport(&mt6835_sim_transport);
+    handle = mt6835_sim_handle(&sim);
+
+    verificar("snapshot_read sin attach: ESP_ERR_INVALID_STATE",
+              mt6835_snapshot_read(&handle, &original, 1) == ESP_ERR_INVALID_STATE);
+
+    mt6835_attach(&handle);
+    sim.regs[USER_ID] = 0x11;
+    sim.regs[BW] = 0x03;
+    sim.regs[NLC_START + 10] = 0x77;
+
+    verificar("snapshot_read: una transaccion con NLC",
+              mt6835_snapshot_read(&handle, &original, 1) == ESP_OK && sim.transactions == 1 &&
+              original.conNlc && original.regs[USER_ID - USER_ID] == 0x11 && original.nlc[10] == 0x77);
+    verificar("snapshot_compare: igual a si mismo", mt6835_snapshot_compare(&original, &original) == 0);
+
+    // 1) Un registro escribible cambiado: exactamente esa diferencia
+    mt6835_set_user_id(&handle, 0x22);
+    mt6835_snapshot_read(&handle, &cambiado, 1);
+
+    verificar("un registro cambiado: una diferencia", mt6835_snapshot_compare(&original, &cambiado) == 1);
+    verificar("un registro cambiado: es USER_ID", distinto(&original, &cambiado) == USER_ID - USER_ID);
+
+    // 2) El angulo cambia en cada lectura y no se compara
+    sim.angle += 123456;
+    mt6835_snapshot_read(&handle, &leido, 1);
+    verificar("angulo cambiado: sin diferencias", mt6835_snapshot_compare(&cambiado, &leido) == 0);
+
+    // 3) Un byte de la tabla NLC: cuenta solo si las dos imagenes tienen NLC
+    sim.regs[NLC_START + 10] = 0x78;
+    mt6835_snapshot_read(&handle, &leido, 1);
+    mt6835_snapshot_read(&handle, &sinNlc, 0);
+
+    verificar("un byte NLC cambiado: una diferencia", mt6835_snapshot_compare(&cambiado, &leido) == 1);
+    verificar("sin NLC en una imagen: no se compara la tabla",
+              !sinNlc.conNlc && mt6835_snapshot_compare(&cambiado, &sinNlc) == 0);
+
+    // 4) restore: una lectura y una escritura por byte distinto (USER_ID y el byte NLC)
+    mt6835_sim_reset_stats(&sim);
+
+    verificar("restore: una lectura y dos escrituras",
+              mt6835_snapshot_restore(&handle, &original) == ESP_OK && sim.transactions == 3);
+    verificar("restore: el modelo vuelve a la imagen",
+              sim.regs[USER_ID] == 0x11 && sim.regs[NLC_START + 10] == 0x77 && sim.regs[BW] == 0x03);
+
+    mt6835_snapshot_read(&handle, &leido, 1);
+    verificar("restore: snapshot nuevo igual al original", mt6835_snapshot_compare(&original, &leido) == 0);
+
+    mt6835_sim_reset_stats(&sim);
+    verificar("restore de la misma imagen: solo la lectura",
+              mt6835_snapshot_restore(&handle, &original) == ESP_OK && sim.transactions == 1);
+
+    return fallas ? 1 : 0;
+}
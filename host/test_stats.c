@@ -0,0 +1,156 @@
+// Instrumentacion por funcion publica (MT6835_STATS 1) contra el modelo: llamadas, transacciones, bytes en el
+// cable y errores de cada API, incluidas las rutas de varios ejes, streaming y publicacion de la ultima muestra
+// Uso: mt6835_test_stats
+
+#include <stdio.h>
+#include "mt6835_sim.h"
+
+#define LECTURAS    10
+#define EJES        3
+#define BYTES_BURST 6           // 2 de comando y direccion + 4 de angulo y CRC
+#define BYTES_READ  5           // 2 de comando y direccion + 3
+
+static mt6835_sim_t sims[EJES];
+static spi_device_handle_t handles[EJES];
+static mt6835_api_stats_t stats[MT6835_API_COUNT];
+static int fallas;
+
+static void verificar(const char *nombre, int ok) {
+    printf("%-52s %s\n", nombre, ok ? "ok" : "FALLA");
+    fallas += !ok;
+}
+
+// Contadores de una API despues de mt6835_stats_get; el histograma de latencia suma las llamadas
+static int contadores(MT6835_API_t api, uint32_t llamadas, uint32_t transacciones, uint32_t bytes, uint32_t errores) {
+    uint32_t latencia = 0;
+
+    for (int i = 0; i < MT6835_STATS_BUCKETS; i++) {
+        latencia += stats[api].latency[i];
+    }
+
+    return stats[api].calls == llamadas && stats[api].transactions == transacciones &&
+           stats[api].bytes == bytes && stats[api].errors == errores && latencia == llamadas;
+}
+
+// Ninguna otra API del dispositivo tiene llamadas ni transacciones
+static int solo(MT6835_API_t a, MT6835_API_t b) {
+    for (int i = 0; i < MT6835_API_COUNT; i++) {
+        if (i != a && i != b && (stats[i].calls != 0 || stats[i].transactions != 0)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void leer_stats(int eje) {
+    mt6835_stats_get(&handles[eje], stats);
+}
+
+static void reiniciar(void) {
+    for (int i = 0; i < EJES; i++) {
+        mt6835_stats_reset(&handles[i]);
+        mt6835_sim_reset_stats(&sims[i]);
+    }
+}
+
+int main(void) {
+    uint32_t angle;
+
+    mt6835_set_transport(&mt6835_sim_transport);
+
+    for (int i = 0; i < EJES; i++) {
+        mt6835_sim_init(&sims[i]);
+        handles[i] = mt6835_sim_handle(&sims[i]);
+    }
+
+    verificar("stats_get sin attach: ESP_ERR_INVALID_STATE", mt6835_stats_get(&handles[0], stats) == ESP_ERR_INVALID_STATE);
+
+    for (int i = 0; i < EJES; i++) {
+        mt6835_attach(&handles[i]);
+    }
+
+    reiniciar();
+
+    // 1) Lecturas de angulo: una transaccion burst o cuatro READ por llamada
+    for (int i = 0; i < LECTURAS; i++) {
+        mt6835_get_angle_burst(&handles[0], &angle);
+        mt6835_get_angle(&handles[0], &angle);
+    }
+
+    leer_stats(0);
+    verificar("get_angle_burst: llamadas, transacciones y bytes",
+              contadores(MT6835_API_GET_ANGLE_BURST, LECTURAS, LECTURAS, LECTURAS * BYTES_BURST, 0));
+    verificar("get_angle: cuatro READ por llamada",
+              contadores(MT6835_API_GET_ANGLE, LECTURAS, 4 * LECTURAS, 4 * LECTURAS * BYTES_READ, 0));
+    verificar("get_angle: coincide con el modelo",
+              sims[0].transactions == 5 * LECTURAS && sims[0].bytes == LECTURAS * (BYTES_BURST + 4 * BYTES_READ));
+    verificar("get_angle: ninguna otra API", solo(MT6835_API_GET_ANGLE_BURST, MT6835_API_GET_ANGLE));
+
+    // 2) CRC corrupto: error en la API que hizo la lectura
+    sims[0].corruptCrc = 1;
+    mt6835_get_angle_burst(&handles[0], &angle);
+    sims[0].corruptCrc = 0;
+    leer_stats(0);
+    verificar("get_angle_burst con CRC corrupto: un error",
+              contadores(MT6835_API_GET_ANGLE_BURST, LECTURAS + 1, LECTURAS + 1, (LECTURAS + 1) * BYTES_BURST, 1));
+
+    // 3) Scheduler: una llamada y una lectura burst en el dispositivo de cada eje
+    mt6835_sched_t sched;
+    mt6835_sched_sample_t muestra;
+
+    reiniciar();
+    mt6835_sched_init(&sched);
+
+    for (int i = 0; i < EJES; i++) {
+        mt6835_sched_add(&sched, &handles[i]);
+    }
+
+    for (int i = 0; i < LECTURAS; i++) {
+        mt6835_sched_read(&sched, &muestra);
+    }
+
+    uint32_t ejesOk = 0;
+
+    for (int i = 0; i < EJES; i++) {
+        leer_stats(i);
+        ejesOk += contadores(MT6835_API_SCHED_READ, LECTURAS, LECTURAS, LECTURAS * BYTES_BURST, 0) &&
+                  solo(MT6835_API_SCHED_READ, MT6835_API_SCHED_READ);
+    }
+
+    verificar("sched_read: en cada eje", ejesOk == EJES);
+
+    // 4) Streaming: start encola MT6835_STREAM_DEPTH lecturas, service solo las retira
+    static mt6835_stream_t stream;
+
+    reiniciar();
+    mt6835_stream_start(&handles[0], &stream);
+    leer_stats(0);
+    verificar("stream_start: MT6835_STREAM_DEPTH lecturas",
+              contadores(MT6835_API_STREAM_START, 1, MT6835_STREAM_DEPTH, MT6835_STREAM_DEPTH * BYTES_BURST, 0));
+
+    mt6835_stream_service(&stream, 0);
+    leer_stats(0);
+    verificar("stream_service: retira y reencola",
+              stats[MT6835_API_STREAM_SERVICE].calls == 1 &&
+              stats[MT6835_API_STREAM_SERVICE].transactions == sims[0].transactions - MT6835_STREAM_DEPTH &&
+              stats[MT6835_API_STREAM_SERVICE].bytes == stats[MT6835_API_STREAM_SERVICE].transactions * BYTES_BURST);
+    mt6835_stream_stop(&stream);
+
+    // 5) Ultima muestra: la lectura de acquire se cuenta en la funcion mas interna, la burst
+    reiniciar();
+    mt6835_latest_publish(&handles[0], 1234, 5678);
+    mt6835_latest_acquire(&handles[0]);
+    leer_stats(0);
+    verificar("latest_publish: dos llamadas, sin transacciones", contadores(MT6835_API_LATEST_PUBLISH, 2, 0, 0, 0));
+    verificar("latest_acquire: la lectura en get_angle_burst",
+              contadores(MT6835_API_LATEST_ACQUIRE, 1, 0, 0, 0) &&
+              contadores(MT6835_API_GET_ANGLE_BURST, 1, 1, BYTES_BURST, 0));
+
+    // 6) stats_reset deja todo en cero
+    mt6835_stats_reset(&handles[0]);
+    leer_stats(0);
+    verificar("stats_reset: contadores en cero", solo(MT6835_API_COUNT, MT6835_API_COUNT));
+
+    return fallas ? 1 : 0;
+}
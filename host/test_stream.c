@@ -0,0 +1,147 @@
+// Buffer circular y modo streaming: orden con un productor y un consumidor en hilos distintos,
+// descarte de muestras con el buffer lleno y vaciado de la cola del driver en mt6835_stream_stop
+// Uso: mt6835_test_stream
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include "mt6835_sim.h"
+
+#define MUESTRAS_HILOS  200000
+#define VELOCIDAD       1234    // Cuentas por transaccion del modelo
+
+static int fallas;
+
+static void verificar(const char *nombre, int ok) {
+    printf("%-52s %s\n", nombre, ok ? "ok" : "FALLA");
+    fallas += !ok;
+}
+
+static mt6835_ring_t ring;
+
+// El productor reintenta con el buffer lleno para que el consumidor reciba todas las muestras
+// Los dos hilos ceden la CPU al esperar, con un solo nucleo el otro hilo no correria hasta el fin del quantum
+static void *productor(void *arg) {
+    for (uint32_t i = 0; i < MUESTRAS_HILOS; i++) {
+        mt6835_sample_t muestra = { .timestamp = i, .raw = i, .crc = i & 0xFF, .crcOk = 1 };
+
+        while (!mt6835_ring_push(&ring, &muestra)) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void probar_ring_hilos(void) {
+    pthread_t hilo;
+    mt6835_sample_t muestra;
+    uint32_t esperada = 0, desordenadas = 0;
+
+    mt6835_ring_init(&ring);
+    pthread_create(&hilo, NULL, productor, NULL);
+
+    while (esperada < MUESTRAS_HILOS) {
+        if (!mt6835_ring_pop(&ring, &muestra)) {
+            sched_yield();
+            continue;
+        }
+
+        // Una muestra cortada o fuera de orden rompe la relacion entre los campos
+        if (muestra.raw != esperada || muestra.timestamp != esperada || muestra.crc != (esperada & 0xFF)) {
+            desordenadas++;
+        }
+
+        esperada++;
+    }
+
+    pthread_join(hilo, NULL);
+
+    verificar("ring: orden entre hilos sin muestras cortadas", desordenadas == 0);
+    verificar("ring: vacio al terminar", mt6835_ring_count(&ring) == 0 && !mt6835_ring_pop(&ring, &muestra));
+}
+
+static void probar_ring_lleno(void) {
+    mt6835_sample_t muestra;
+    uint32_t aceptadas = 0, orden = 1;
+
+    mt6835_ring_init(&ring);
+
+    for (uint32_t i = 0; i < MT6835_RING_SIZE + 10; i++) {
+        muestra = (mt6835_sample_t) { .raw = i };
+        aceptadas += mt6835_ring_push(&ring, &muestra);
+    }
+
+    verificar("ring lleno: acepta MT6835_RING_SIZE muestras", aceptadas == MT6835_RING_SIZE);
+    verificar("ring lleno: cuenta los descartes en overruns", ring.overruns == 10);
+
+    // Se descartan las nuevas, las que estaban quedan intactas
+    for (uint32_t i = 0; i < MT6835_RING_SIZE; i++) {
+        orden &= mt6835_ring_pop(&ring, &muestra) && muestra.raw == i;
+    }
+
+    verificar("ring lleno: conserva las muestras viejas en orden", orden && !mt6835_ring_pop(&ring, &muestra));
+}
+
+static void probar_stream(void) {
+    static mt6835_sim_t sim;
+    static mt6835_stream_t stream;
+    spi_device_handle_t handle;
+    mt6835_sample_t muestra, anterior;
+    uint32_t recibidas = 0, saltos = 0, crcMalos = 0, atrasadas = 0;
+
+    mt6835_sim_init(&sim);
+    mt6835_set_transport(&mt6835_sim_transport);
+    handle = mt6835_sim_handle(&sim);
+    mt6835_attach(&handle);
+    sim.velocity = VELOCIDAD;
+
+    verificar("stream: start encola MT6835_STREAM_DEPTH lecturas",
+              mt6835_stream_start(&handle, &stream) == ESP_OK && stream.enCola == MT6835_STREAM_DEPTH &&
+              sim.queueHead - sim.queueTail == MT6835_STREAM_DEPTH);
+
+    // Solo hay lecturas de angulo en el bus: muestras consecutivas difieren en VELOCIDAD
+    for (int i = 0; i < 1000; i++) {
+        mt6835_stream_service(&stream, 0);
+
+        while (mt6835_ring_pop(&stream.ring, &muestra)) {
+            if (recibidas > 0) {
+                saltos += mt6835_angle21_diff(mt6835_raw_to_angle21(muestra.raw), mt6835_raw_to_angle21(anterior.raw)) != VELOCIDAD;
+                atrasadas += muestra.timestamp < anterior.timestamp;
+            }
+
+            crcMalos += !muestra.crcOk;
+            anterior = muestra;
+            recibidas++;
+        }
+    }
+
+    verificar("stream: todas las muestras en orden", recibidas == 1000 * MT6835_STREAM_DEPTH && saltos == 0 && atrasadas == 0);
+    verificar("stream: CRC valido en todas", crcMalos == 0);
+
+    // Sin consumidor el ring se llena y las muestras nuevas se descartan
+    for (int i = 0; i < MT6835_RING_SIZE / MT6835_STREAM_DEPTH + 10; i++) {
+        mt6835_stream_service(&stream, 0);
+    }
+
+    verificar("stream: ring lleno cuenta overruns",
+              mt6835_ring_count(&stream.ring) == MT6835_RING_SIZE && stream.ring.overruns == 10 * MT6835_STREAM_DEPTH);
+
+    // stop retira todo lo encolado y no vuelve a encolar
+    verificar("stream: stop vacia la cola del driver",
+              mt6835_stream_stop(&stream) == ESP_OK && stream.enCola == 0 && sim.queueHead == sim.queueTail);
+
+    uint32_t transacciones = sim.transactions;
+
+    mt6835_stream_service(&stream, 0);
+
+    verificar("stream: sin transacciones despues de stop", sim.transactions == transacciones && !stream.activo);
+}
+
+int main(void) {
+    probar_ring_hilos();
+    probar_ring_lleno();
+    probar_stream();
+
+    return fallas ? 1 : 0;
+}
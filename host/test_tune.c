@@ -0,0 +1,129 @@
+// Auto ajuste de BW contra el modelo de ruido y filtro: el ruido medido sigue al ruido del modelo y baja con
+// BW, el retardo sigue a filterShift, y tune_select elige el BW de menor ruido dentro del retardo pedido
+// Uso: mt6835_test_tune
+
+#include <stdio.h>
+#include <math.h>
+#include "mt6835_sim.h"
+
+#define MUESTRAS    2000        // Mas de 15 constantes de tiempo con filterShift 7
+#define VELOCIDAD   300         // Cuentas por transaccion en el barrido de retardo
+#define TOLERANCIA  0.15        // Relativa, ruido medido contra el teorico del modelo
+#define BW_TEORICO  4           // Hasta este BW se compara contra el teorico
+
+static mt6835_sim_t sim;
+static spi_device_handle_t handle;
+static int fallas;
+
+static void verificar(const char *nombre, int ok) {
+    printf("%-52s %s\n", nombre, ok ? "ok" : "FALLA");
+    fallas += !ok;
+}
+
+// Referencia perfecta: el angulo mecanico del modelo
+static uint32_t referencia(void *arg) {
+    return ((mt6835_sim_t *)arg)->angle;
+}
+
+// Desvio del filtro y += (x - y) / 2^shift con ruido uniforme de +-noise: varianza a / (2 - a) de la entrada
+static double ruido_teorico(uint32_t noise, uint8_t shift) {
+    double a = 1.0 / (1 << shift);
+
+    return noise / sqrt(3.0) * sqrt(a / (2.0 - a));
+}
+
+int main(void) {
+    static const uint32_t niveles[] = { 30, 120, 480 };
+    mt6835_tune_t tune[3], lag;
+    uint8_t bw = 0xFF;
+
+    mt6835_sim_init(&sim);
+    mt6835_set_transport(&mt6835_sim_transport);
+    handle = mt6835_sim_handle(&sim);
+    mt6835_attach(&handle);
+    mt6835_set_bw(&handle, 5);
+
+    // 1) Ruido con el motor detenido, tres niveles de ruido del modelo
+    uint32_t crece = 0, baja = 0, teorico = 0;
+
+    for (int n = 0; n < 3; n++) {
+        sim.noise = niveles[n];
+        mt6835_tune_init(&tune[n]);
+        fallas += mt6835_tune_noise(&handle, MUESTRAS, &tune[n]) != ESP_OK;
+
+        printf("%-52s", n == 0 ? "ruido por BW (noise 30, 120, 480):" : "");
+
+        for (int i = 0; i < 8; i++) {
+            printf(" %.1f", tune[n].ruido[i]);
+            baja += i > 0 && tune[n].ruido[i] >= tune[n].ruido[i - 1];
+            crece += n > 0 && tune[n].ruido[i] <= tune[n - 1].ruido[i];
+            // Con BW alto las muestras estan correlacionadas y MUESTRAS son pocas constantes de tiempo
+            teorico += i <= BW_TEORICO &&
+                       fabs(tune[n].ruido[i] / ruido_teorico(niveles[n], sim.filterShift[i]) - 1.0) > TOLERANCIA;
+        }
+
+        printf("\n");
+    }
+
+    verificar("tune_noise: los 8 BW medidos, BW restaurado",
+              tune[0].medidoRuido == 0xFF && (sim.regs[BW] & 0x07) == 5);
+    verificar("tune_noise: sube con el ruido del modelo", crece == 0);
+    verificar("tune_noise: baja con BW", baja == 0);
+    verificar("tune_noise: igual al filtro del modelo hasta BW 4", teorico == 0);
+
+    // 2) Retardo a velocidad constante sin ruido: el filtro atrasa VELOCIDAD * 2^shift cuentas
+    uint32_t retardoCrece = 0, retardoModelo = 0;
+
+    sim.noise = 0;
+    sim.velocity = VELOCIDAD;
+    mt6835_tune_init(&lag);
+
+    verificar("tune_lag: sin referencia ESP_ERR_INVALID_ARG",
+              mt6835_tune_lag(&handle, MUESTRAS, NULL, NULL, &lag) == ESP_ERR_INVALID_ARG);
+    verificar("tune_lag: ESP_OK", mt6835_tune_lag(&handle, MUESTRAS, referencia, &sim, &lag) == ESP_OK);
+
+    printf("%-52s", "retardo por BW (cuentas):");
+
+    for (int i = 0; i < 8; i++) {
+        printf(" %.0f", lag.retardoCuentas[i]);
+        retardoCrece += i > 0 && !(lag.retardoUs[i] > lag.retardoUs[i - 1]);
+        retardoModelo += fabs(lag.retardoCuentas[i] - VELOCIDAD * (1 << sim.filterShift[i])) > 1.0;
+    }
+
+    printf("\n");
+    verificar("tune_lag: los 8 BW medidos, BW restaurado", lag.medidoRetardo == 0xFF && (sim.regs[BW] & 0x07) == 5);
+    verificar("tune_lag: sube con filterShift", retardoCrece == 0);
+    verificar("tune_lag: VELOCIDAD * 2^filterShift", retardoModelo == 0);
+
+    // 3) Otro filtro en el modelo: el retardo lo sigue
+    mt6835_tune_t invertido;
+
+    for (int i = 0; i < 8; i++) {
+        sim.filterShift[i] = 7 - i;
+    }
+
+    mt6835_tune_init(&invertido);
+    mt6835_tune_lag(&handle, MUESTRAS, referencia, &sim, &invertido);
+    verificar("tune_lag: filterShift invertido, retardo invertido",
+              fabs(invertido.retardoCuentas[0] - lag.retardoCuentas[7]) <= 1.0 &&
+              fabs(invertido.retardoCuentas[7] - lag.retardoCuentas[0]) <= 1.0);
+
+    // 4) select: menor ruido con retardo hasta el punto medio entre BW 3 y BW 4 -> BW 3
+    float maximo = (lag.retardoUs[3] + lag.retardoUs[4]) / 2;
+
+    tune[1].medidoRetardo = lag.medidoRetardo;
+
+    for (int i = 0; i < 8; i++) {
+        tune[1].retardoCuentas[i] = lag.retardoCuentas[i];
+        tune[1].retardoUs[i] = lag.retardoUs[i];
+    }
+
+    verificar("tune_select: BW 3 y lo escribe",
+              mt6835_tune_select(&handle, &tune[1], maximo, &bw) == ESP_OK && bw == 3 && (sim.regs[BW] & 0x07) == 3);
+    verificar("tune_select: sin retardo posible ESP_ERR_NOT_FOUND",
+              mt6835_tune_select(&handle, &tune[1], lag.retardoUs[0] / 2, &bw) == ESP_ERR_NOT_FOUND);
+    verificar("tune_select: sin limite el de menor ruido",
+              mt6835_tune_select(&handle, &tune[1], INFINITY, &bw) == ESP_OK && bw == 7);
+
+    return fallas ? 1 : 0;
+}
@@ -1,772 +1,2776 @@
 #include "mt6835.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_attr.h"
+#include "mt6835_seqlock.h"
+#include <stdatomic.h>
+#include <math.h>
 
 static const char *tag = "MT6835";
 
-esp_err_t mt6835_get_user_id(spi_device_handle_t *mt6835Handle, uint8_t *userID) {
-    esp_err_t error;
+#if MT6835_LOG_MODE == MT6835_LOG_TRACE
+// Buffer circular de eventos, se sobreescriben los mas viejos
+static mt6835_trace_t traceBuf[MT6835_TRACE_SIZE];
+static _Atomic uint32_t traceHead;
+
+#define MT6835_TRACE(evt_, reg_, val_) do {                                                     \
+        uint32_t i_ = atomic_fetch_add_explicit(&traceHead, 1, memory_order_relaxed);           \
+        mt6835_trace_t *e_ = &traceBuf[i_ & (MT6835_TRACE_SIZE - 1)];                           \
+        e_->timestamp = esp_cpu_get_cycle_count();                                              \
+        e_->value = (val_);                                                                     \
+        e_->reg = (reg_);                                                                       \
+        e_->event = (evt_);                                                                     \
+    } while (0)
+#else
+#define MT6835_TRACE(evt, reg, val) do { } while (0)
+#endif
+
+#if MT6835_LOG_MODE == MT6835_LOG_PRINTF
+#define MT6835_PRINTF(...) printf(__VA_ARGS__)
+#else
+#define MT6835_PRINTF(...) do { } while (0)
+#endif
+
+// Registros de configuracion que se pueden guardar en cache (USER_ID a BW, sin angulo/CRC ni 0x00F/0x010)
+#define MT6835_CACHE_MASK ((1 << (USER_ID - USER_ID)) | (0x0FF << (ABZ_RES_HIGH - USER_ID)) | (1 << (BW - USER_ID)))
+
+// Transporte por defecto: driver SPI de ESP-IDF
+static const mt6835_transport_t transporteIdf = {
+    .transmit = spi_device_transmit,
+    .polling_transmit = spi_device_polling_transmit,
+    .queue_trans = spi_device_queue_trans,
+    .get_trans_result = spi_device_get_trans_result,
+    .acquire_bus = spi_device_acquire_bus,
+    .release_bus = spi_device_release_bus
+};
+
+static const mt6835_transport_t *transporte = &transporteIdf;
+
+void mt6835_set_transport(const mt6835_transport_t *nuevo) {
+    transporte = (nuevo != NULL) ? nuevo : &transporteIdf;
+}
 
-    spi_transaction_t operacion = {
-        .cmd = READ,
-        .addr = USER_ID,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
-    };
+// Estado por dispositivo, se asigna un slot la primera vez que se usa cada handle
+typedef struct {
+    spi_device_handle_t handle;
+    uint8_t regs[MT6835_CONF_SIZE];     // Copia de USER_ID..BW, indice = direccion - USER_ID
+    uint32_t valid;                     // Bit i en 1 = regs[i] coincide con el registro
+    uint32_t transacciones;
+    spi_transaction_t fastOp;           // Lectura burst preconstruida para la ruta rapida
+    mt6835_stamp_t fastStamp;           // user de fastOp
+    uint8_t busTomado;                  // 1 entre mt6835_fast_begin y mt6835_fast_end
+    const mt6835_lut_t *lut;            // Correccion de linealidad por software, NULL = sin correccion
+    mt6835_angle21_t zeroOffset;        // Cero por software a resolucion completa, se resta despues del cero del MT6835
+    mt6835_faults_t faults;
+    spi_transaction_t asyncOps[2];      // Doble buffer de lecturas asincronicas
+    uint8_t asyncEnCola;
+    uint8_t asyncSiguiente;             // Descriptor a usar en el proximo encolado
+    uint8_t asyncPipeline;
+    mt6835_read_cb_t asyncCb;
+    void *asyncArg;
+    uint8_t sinGrabar;                  // 1 si hubo escrituras desde el arranque o la ultima grabacion de EEPROM
+    uint8_t eepromOcupada;              // 1 entre mt6835_eeprom_start y el fin de la espera
+    esp_err_t eepromResultado;          // Resultado de la ultima grabacion
+    int64_t eepromFin;                  // us, fin de la espera de grabacion
+    mt6835_snapshot_t eepromImagen;     // Imagen grabada, para verificar al terminar
+    _Atomic uint32_t pubSeq;            // Seqlock de pub, impar mientras el escritor actualiza
+    mt6835_latest_t pub;
+    mt6835_timing_t timing;
+#if MT6835_STATS
+    mt6835_api_stats_t stats[MT6835_API_COUNT];
+    uint8_t apiActual;                  // Funcion publica en curso, para atribuir transacciones
+#endif
+} mt6835_dev_t;
+
+static mt6835_dev_t devices[MT6835_MAX_DEVICES];
+
+// Solo lectura: el slot lo asigna mt6835_attach, NULL si el handle no se registro
+static mt6835_dev_t *mt6835_dev(spi_device_handle_t *mt6835Handle) {
+    for (int i = 0; i < MT6835_MAX_DEVICES; i++) {
+        if (__atomic_load_n(&devices[i].handle, __ATOMIC_ACQUIRE) == *mt6835Handle) {
+            return &devices[i];
+        }
+    }
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
-    
-    if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al realizar transacción: %s", esp_err_to_name(error));
-        return error;
+    return NULL;
+}
+
+esp_err_t mt6835_attach(spi_device_handle_t *mt6835Handle) {
+    if (mt6835Handle == NULL || *mt6835Handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    *userID = operacion.rx_data[0];
+    if (mt6835_dev(mt6835Handle) != NULL) {
+        return ESP_OK;
+    }
 
-    printf("ID leido: %d\n", *userID);
+    // El slot se reclama con CAS para que dos tareas no tomen el mismo
+    for (int i = 0; i < MT6835_MAX_DEVICES; i++) {
+        spi_device_handle_t libre = NULL;
 
-    return ESP_OK;  
+        if (__atomic_compare_exchange_n(&devices[i].handle, &libre, *mt6835Handle, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return ESP_OK;
+        }
+
+        if (libre == *mt6835Handle) {
+            return ESP_OK;
+        }
+    }
+
+    // Tabla llena: el dispositivo funciona sin cache ni contadores
+    ESP_LOGW(tag, "Maximo de %d dispositivos registrados", MT6835_MAX_DEVICES);
+
+    return ESP_ERR_NO_MEM;
 }
 
-esp_err_t mt6835_set_user_id(spi_device_handle_t *mt6835Handle, uint8_t userID) {
-    esp_err_t error;
+static void mt6835_count(mt6835_dev_t *dev, const spi_transaction_t *operacion) {
+    if (dev != NULL) {
+        dev->transacciones++;
+#if MT6835_STATS
+        // 4 bits de comando + 12 de direccion + datos
+        dev->stats[dev->apiActual].transactions++;
+        dev->stats[dev->apiActual].bytes += 2 + operacion->length / 8;
+#endif
+    }
+}
 
-    spi_transaction_t operacion = {
-        .cmd = WRITE,
-        .addr = USER_ID,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
-    };
+static esp_err_t mt6835_transmit(spi_device_handle_t *mt6835Handle, mt6835_dev_t *dev, spi_transaction_t *operacion) {
+    esp_err_t error;
 
-    operacion.tx_data[0] = userID;
+    mt6835_count(dev, operacion);
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    error = transporte->transmit(*mt6835Handle, operacion);
 
-    if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al transmitir ID nuevo: %s", esp_err_to_name(error));
-        return error;
+#if MT6835_STATS
+    if (error != ESP_OK && dev != NULL) {
+        dev->stats[dev->apiActual].errors++;
     }
+#endif
+
+    return error;
+}
 
-    printf("ID registrado: %d\n", userID);
+// Corren en la ISR del driver SPI (o en la tarea, con polling)
+void IRAM_ATTR mt6835_spi_pre_cb(spi_transaction_t *trans) {
+    mt6835_stamp_t *stamp = trans->user;
 
-    return ESP_OK;
+    if (stamp != NULL) {
+        stamp->inicio = esp_timer_get_time();
+    }
 }
 
-esp_err_t mt6835_get_angle(spi_device_handle_t *mt6835Handle, uint32_t *angle) {
-    esp_err_t error;
-    uint32_t regRx = 0, temp = 0;
+void IRAM_ATTR mt6835_spi_post_cb(spi_transaction_t *trans) {
+    mt6835_stamp_t *stamp = trans->user;
 
-    spi_transaction_t operacion = {
-        .cmd = READ,
-        .addr = ANGLE_HIGH,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
-    };
+    if (stamp != NULL) {
+        stamp->fin = esp_timer_get_time();
+    }
+}
 
-    for (int i = 0; i < 4; i++) {
-        // Primeras 3 iteraciones leo angulo y en 4ta leo CRC
-        error = spi_device_transmit(*mt6835Handle, &operacion);
+// Registra los tiempos de una adquisicion de angulo
+// Con los callbacks instalados usa los tiempos de la transaccion, si no los de la tarea (inicio queda antes
+// de encolar en el driver, unos us antes de que baje CS)
+static inline void mt6835_timing_update(mt6835_dev_t *dev, const mt6835_stamp_t *stamp, int64_t inicio, int64_t fin) {
+    inicio = (stamp->inicio != 0) ? stamp->inicio : inicio;
+    fin = (stamp->fin != 0) ? stamp->fin : fin;
 
-        if (error != ESP_OK) {
-            ESP_LOGE(tag, "Error al leer registro 0x%03X: %s", operacion.addr+i, esp_err_to_name(error));
-            return error;
-        }
+    uint32_t latencia = fin - inicio;
 
-        regRx = operacion.rx_data[0];
+    dev->timing.inicio = inicio;
+    dev->timing.fin = fin;
+    dev->timing.latencia = latencia;
 
-        if (i < 3) {
-            temp |= (regRx << (16 - 8*i));
-        }
+    if (latencia > dev->timing.latenciaMax) {
+        dev->timing.latenciaMax = latencia;
+    }
+}
 
-        operacion.addr++;
+#if MT6835_STATS
+// Se declara al principio de cada funcion publica, al salir de la funcion (por cualquier return)
+// se registra la latencia en el histograma de esa funcion
+typedef struct {
+    mt6835_dev_t *dev;
+    uint32_t inicio;
+    uint8_t api;
+    uint8_t anterior;
+} mt6835_stats_scope_t;
+
+static inline mt6835_stats_scope_t mt6835_stats_begin(mt6835_dev_t *dev, uint8_t api) {
+    mt6835_stats_scope_t scope = { .dev = dev, .api = api };
+
+    if (scope.dev != NULL) {
+        // Las transacciones de funciones anidadas se cuentan en la mas interna
+        scope.anterior = scope.dev->apiActual;
+        scope.dev->apiActual = api;
     }
 
-    // Retorno 21 bits de angulo + 3 bits de estado, tener en cuenta al usar
-    *angle = temp;
+    scope.inicio = esp_cpu_get_cycle_count();
 
-    return ESP_OK;
+    return scope;
 }
 
-uint8_t calculate_crc(uint32_t angle) {
-    // Obtenida de https://github.com/simplefoc/Arduino-FOC-drivers/blob/master/src/encoders/mt6835/MT6835.cpp
-    // El CRC usado es distinto de los CRC8 estandar
-    uint8_t crc = 0x00;
+static void mt6835_stats_end(mt6835_stats_scope_t *scope) {
+    uint32_t ciclos = esp_cpu_get_cycle_count() - scope->inicio;
 
-    uint8_t input = angle>>13;
-    crc ^= input;
-    for (int k = 8; k > 0; k--)
-        crc = (crc & (0x01<<7))?(crc<<1)^0x07:crc<<1;
+    if (scope->dev == NULL) {
+        return;
+    }
 
-    input = (angle>>5) & 0xFF;
-    crc ^= input;
-    for (int k = 8; k > 0; k--)
-        crc = (crc & (0x01<<7))?(crc<<1)^0x07:crc<<1;
+    // Bucket logaritmico: 0 para menos de 2^(SHIFT+1) ciclos, despues uno por potencia de 2
+    int bucket = (ciclos >> MT6835_STATS_SHIFT) ? (31 - __builtin_clz(ciclos >> MT6835_STATS_SHIFT)) : 0;
 
-    input = ((angle<<3) & 0xFF);
-    crc ^= input;
-    for (int k = 8; k > 0; k--)
-        crc = (crc & (0x01<<7))?(crc<<1)^0x07:crc<<1;
+    bucket = (bucket < MT6835_STATS_BUCKETS) ? bucket : MT6835_STATS_BUCKETS - 1;
 
-    return crc;
+    scope->dev->stats[scope->api].calls++;
+    scope->dev->stats[scope->api].latency[bucket]++;
+    scope->dev->apiActual = scope->anterior;
 }
 
-// NO FUNCA TODAVIA
-esp_err_t mt6835_program_eeprom(spi_device_handle_t *mt6835Handle) {
+#define MT6835_STATS_SCOPE(dev, api) \
+    mt6835_stats_scope_t statsScope __attribute__((cleanup(mt6835_stats_end))) = mt6835_stats_begin(dev, api)
+#else
+#define MT6835_STATS_SCOPE(dev, api) (void)(dev)
+#endif
+
+// Lee un registro, si es de configuracion y esta en cache no hay transaccion
+static esp_err_t mt6835_read_reg(spi_device_handle_t *mt6835Handle, mt6835_dev_t *dev, uint16_t addr, uint8_t *valor) {
     esp_err_t error;
+    uint32_t bit = (addr >= USER_ID && addr <= BW) ? (MT6835_CACHE_MASK & (1 << (addr - USER_ID))) : 0;
+
+    if (dev != NULL && (dev->valid & bit)) {
+        *valor = dev->regs[addr - USER_ID];
+        return ESP_OK;
+    }
 
     spi_transaction_t operacion = {
-        .cmd = PROG_EEPROM,
-        .addr = 0x000,
+        .cmd = READ,
+        .addr = addr,
         .length = 24,
         .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
     };
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
-    
-    if (error != ESP_OK || operacion.rx_data[0] != 0x55) {
-        ESP_LOGE(tag, "Error al grabar EEPROM: %s", esp_err_to_name(error));
-        ESP_LOGE(tag, "ACK: 0x%02X != 0x55", operacion.rx_data[0]);
+    error = mt6835_transmit(mt6835Handle, dev, &operacion);
+
+    if (error != ESP_OK) {
         return error;
     }
 
-    ESP_LOGI(tag, "EEPROM grabada correctamente, esperar 6s");
+    *valor = operacion.rx_data[0];
 
-    vTaskDelay(pdMS_TO_TICKS(6000));
+    if (dev != NULL && bit) {
+        dev->regs[addr - USER_ID] = *valor;
+        dev->valid |= bit;
+    }
 
-    return ESP_OK;  
+    return ESP_OK;
 }
 
-esp_err_t mt6835_get_abz_res(spi_device_handle_t *mt6835Handle, uint16_t *abzRes) {
+// Escribe un registro y actualiza la cache, si el valor en cache ya es el pedido no hay transaccion
+static esp_err_t mt6835_write_reg(spi_device_handle_t *mt6835Handle, mt6835_dev_t *dev, uint16_t addr, uint8_t valor) {
     esp_err_t error;
-    uint16_t temp = 0;
+    uint32_t bit = (addr >= USER_ID && addr <= BW) ? (MT6835_CACHE_MASK & (1 << (addr - USER_ID))) : 0;
+
+    if (dev != NULL && (dev->valid & bit) && dev->regs[addr - USER_ID] == valor) {
+        return ESP_OK;
+    }
 
     spi_transaction_t operacion = {
-        .cmd = READ,
-        .addr = ABZ_RES_HIGH,
+        .cmd = WRITE,
+        .addr = addr,
         .length = 24,
         .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
     };
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    operacion.tx_data[0] = valor;
+
+    error = mt6835_transmit(mt6835Handle, dev, &operacion);
 
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al leer resolucion (0x%03X) ABZ: %s", operacion.addr, esp_err_to_name(error));
+        // No se sabe si el registro cambio
+        if (dev != NULL) {
+            dev->valid &= ~bit;
+        }
         return error;
     }
 
-    temp = operacion.rx_data[0];
-    temp <<= 8;
-
-    // Primero leo BYTE HIGH (0x007) y luego leo BYTE LOW (0x008)
-    operacion.addr = ABZ_RES_LOW;
-
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    if (dev != NULL) {
+        dev->sinGrabar = 1;
 
-    if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al leer resolucion (0x%03X) ABZ: %s", operacion.addr, esp_err_to_name(error));
-        return error;
+        if (bit) {
+            dev->regs[addr - USER_ID] = valor;
+            dev->valid |= bit;
+        }
     }
 
-    // Borro bits del LOW BYTE y luego guardo
-    temp &= 0xFF00;
-    temp |= operacion.rx_data[0];
-
-    // Elimino bits ABZ_OFF y ABZ_SWAP y +1 debido a que ppr = registro + 1
-    *abzRes = ((temp >> 2) + 1) & 0x3FFF;
+    return ESP_OK;
+}
 
-    printf("Leido ABZ_RES: %d\n", *abzRes);
+// Lee registros consecutivos con una sola transaccion BURST_READ
+static esp_err_t mt6835_read_block(spi_device_handle_t *mt6835Handle, mt6835_dev_t *dev, uint16_t addr, uint8_t *datos, uint32_t cantidad) {
+    spi_transaction_t operacion = {
+        .cmd = BURST_READ,
+        .addr = addr,
+        .length = 8 * cantidad,
+        .tx_buffer = NULL,
+        .rx_buffer = datos
+    };
 
-    return ESP_OK;
+    return mt6835_transmit(mt6835Handle, dev, &operacion);
 }
 
-esp_err_t mt6835_set_abz_res(spi_device_handle_t *mt6835Handle, uint16_t abzRes) {
-    if (abzRes == 0) {
-        ESP_LOGW(tag, "Resolucion minima: 1 ppr");
-        return ESP_FAIL;
+// Correcciones por software de la ruta de lectura: linealidad y cero fino. Conserva los bits de estado
+static inline uint32_t mt6835_correct(const mt6835_dev_t *dev, uint32_t raw) {
+    if (dev->lut != NULL) {
+        raw = mt6835_lut_apply(dev->lut, raw);
     }
 
-    esp_err_t error;
+    return (raw - (dev->zeroOffset << 3)) & 0xFFFFFF;
+}
 
-    // Para almacenar ABZ_OFF y ABZ_SWAP
-    uint8_t abzOff = 0, abzSwap = 0, temp = 0;
+// Avanza el histograma hasta la ventana de 'ahora', borrando las ventanas que quedaron sin fallas
+static void mt6835_fault_advance(mt6835_faults_t *faults, int64_t ahora) {
+    uint32_t ventana = (uint32_t)(ahora >> MT6835_FAULT_WINDOW_SHIFT);
+    uint32_t pasadas = ventana - faults->window;
 
-    // Primero leo ABZ_OFF y ABZ_SWAP para no pisar sus valores
-    if (mt6835_get_abz_off(mt6835Handle, &abzOff) != ESP_OK) {
-        return ESP_FAIL;
+    if (pasadas > MT6835_FAULT_WINDOWS) {
+        pasadas = MT6835_FAULT_WINDOWS;
     }
 
-    if (mt6835_get_abz_swap(mt6835Handle, &abzSwap) != ESP_OK) {
-        return ESP_FAIL;
+    for (uint32_t i = 1; i <= pasadas; i++) {
+        faults->histogram[(faults->window + i) % MT6835_FAULT_WINDOWS] = 0;
     }
 
-    spi_transaction_t operacion = {
-        .cmd = WRITE,
-        .addr = ABZ_RES_HIGH,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
-    };
+    faults->window = ventana;
+}
 
-    // High byte del registro
-    operacion.tx_data[0] = ((abzRes-1) >> 6) & 0x00FF;
+// Ruta caliente: sin fallas es un incremento y una comparacion
+static inline void mt6835_fault_update(mt6835_dev_t *dev, uint32_t raw, uint32_t crcFail) {
+    mt6835_faults_t *faults = &dev->faults;
+    uint32_t estado = raw & 0x07;
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    faults->samples++;
 
-    if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al escribir resolucion (0x%03X) ABZ: %s", operacion.addr, esp_err_to_name(error));
-        return error;
+    if ((estado | crcFail) == 0) {
+        return;
     }
 
-    operacion.addr = ABZ_RES_LOW;
+    faults->overspeed += estado & MT6835_STATUS_OVERSPEED;
+    faults->weakField += (estado & MT6835_STATUS_WEAK_FIELD) >> 1;
+    faults->underVoltage += (estado & MT6835_STATUS_UNDERVOLTAGE) >> 2;
+    faults->crcFail += crcFail;
+#if MT6835_STATS
+    dev->stats[dev->apiActual].errors += crcFail;
+#endif
 
-    // Debo restar 1 por que los ppr = valor en registro + 1, por ejemplo, si el registro esta todo en 0, es 1 ppr
-    temp = ((abzRes-1) << 2) & 0x00FF;
-    // Agrego abzOff a ABZ_RES_LOW
-    temp = (abzOff == 1) ? (temp | 0x02) : (temp & 0xFD);
-    // Agrego abzSwap a ABZ_RES_LOW
-    temp = (abzSwap == 1) ? (temp | 0x01) : (temp & 0xFE);
-    
-    operacion.tx_data[0] = temp;
+    mt6835_fault_advance(faults, esp_timer_get_time());
+    faults->histogram[faults->window % MT6835_FAULT_WINDOWS]++;
+}
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+esp_err_t mt6835_cache_invalidate(spi_device_handle_t *mt6835Handle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
 
-    if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al escribir resolucion (0x%03X) ABZ: %s", operacion.addr, esp_err_to_name(error));
-        return error;
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
     }
 
-    printf("Escrito ABZ_RES: %d\n", abzRes);
+    dev->valid = 0;
 
     return ESP_OK;
 }
 
-esp_err_t mt6835_get_abz_off(spi_device_handle_t *mt6835Handle, uint8_t *abzOff) {
+esp_err_t mt6835_cache_refresh(spi_device_handle_t *mt6835Handle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_CACHE_REFRESH);
+
     esp_err_t error;
+    uint8_t rx[MT6835_CONF_SIZE];
 
-    spi_transaction_t operacion = {
-        .cmd = READ,
-        .addr = ABZ_RES_LOW,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
-    };
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    // Leo USER_ID..BW en una sola transaccion burst
+    error = mt6835_read_block(mt6835Handle, dev, USER_ID, rx, MT6835_CONF_SIZE);
 
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al leer ABZ_OFF: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "Error al leer registros de configuracion: %s", esp_err_to_name(error));
+        dev->valid = 0;
         return error;
     }
 
-    *abzOff = (operacion.rx_data[0] & 0x02) >> 1;
+    for (int i = 0; i < MT6835_CONF_SIZE; i++) {
+        dev->regs[i] = rx[i];
+    }
 
-    printf("Leido ABZ_OFF: %d\n", *abzOff);
+    dev->valid = MT6835_CACHE_MASK;
 
     return ESP_OK;
 }
 
-esp_err_t mt6835_set_abz_off(spi_device_handle_t *mt6835Handle, uint8_t abzOff) {
-    esp_err_t error;
-    uint8_t abzResLow = 0;
+uint32_t mt6835_get_transaction_count(spi_device_handle_t *mt6835Handle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
 
-    // Primero debo leer ABZ_RES_LOW para no pisar bits de ABZ_RES ni ABZ_SWAP
-    spi_transaction_t operacion = {
-        .cmd = READ,
-        .addr = ABZ_RES_LOW,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
-    };
+    return (dev != NULL) ? dev->transacciones : 0;
+}
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+void mt6835_reset_transaction_count(spi_device_handle_t *mt6835Handle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
 
-    if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al leer ABZ_RES_LOW: %s", esp_err_to_name(error));
-        return error;
+    if (dev != NULL) {
+        dev->transacciones = 0;
     }
+}
 
-    abzResLow = operacion.rx_data[0];
-    
-    // Una vez leido el registro, lo modifico
-    // Se toma que cualquier numero > 0 en abzOff pondra en 1 el bit del registro
-    abzResLow = (abzOff > 0) ? (abzResLow | 0x02) : (abzResLow & 0xFD);
-
-    operacion.cmd = WRITE;
-    
-    operacion.tx_data[0] = abzResLow;
+esp_err_t mt6835_get_user_id(spi_device_handle_t *mt6835Handle, uint8_t *userID) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_GET_USER_ID);
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    esp_err_t error;
 
+    error = mt6835_read_reg(mt6835Handle, dev, USER_ID, userID);
+    
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al escribir ABZ_RES_LOW: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "Error al realizar transacción: %s", esp_err_to_name(error));
         return error;
     }
 
-    printf("Escrito ABZ_OFF: %d\n", abzOff);
+    MT6835_TRACE(MT6835_EVT_GET_USER_ID, USER_ID, *userID);
+    MT6835_PRINTF("ID leido: %d\n", *userID);
 
-    return ESP_OK;
+    return ESP_OK;  
 }
 
-esp_err_t mt6835_get_abz_swap(spi_device_handle_t *mt6835Handle, uint8_t *abzSwap) {
-    esp_err_t error;
+esp_err_t mt6835_set_user_id(spi_device_handle_t *mt6835Handle, uint8_t userID) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_SET_USER_ID);
 
-    spi_transaction_t operacion = {
-        .cmd = READ,
-        .addr = ABZ_RES_LOW,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
-    };
+    esp_err_t error;
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    error = mt6835_write_reg(mt6835Handle, dev, USER_ID, userID);
 
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al leer ABZ_SWAP: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "Error al transmitir ID nuevo: %s", esp_err_to_name(error));
         return error;
     }
 
-    *abzSwap = operacion.rx_data[0] & 0x01;
-
-    printf("Leido ABZ_SWAP: %d\n", *abzSwap);
+    MT6835_TRACE(MT6835_EVT_SET_USER_ID, USER_ID, userID);
+    MT6835_PRINTF("ID registrado: %d\n", userID);
 
     return ESP_OK;
 }
 
-esp_err_t mt6835_set_abz_swap(spi_device_handle_t *mt6835Handle, uint8_t abzSwap) {
+esp_err_t mt6835_get_angle(spi_device_handle_t *mt6835Handle, uint32_t *angle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_GET_ANGLE);
+
     esp_err_t error;
-    uint8_t abzResLow = 0;
+    uint32_t regRx = 0, temp = 0;
+    mt6835_stamp_t stamp = { 0 };
 
-    // Primero debo leer ABZ_RES_LOW para no pisar bits de ABZ_RES ni ABZ_OFF
+    // Solo la primera lectura lleva stamp: el inicio es el momento en que se congelo ANGLE_HIGH
     spi_transaction_t operacion = {
         .cmd = READ,
-        .addr = ABZ_RES_LOW,
+        .addr = ANGLE_HIGH,
         .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
+        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA,
+        .user = &stamp
     };
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    int64_t inicio = esp_timer_get_time();
 
-    if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al leer ABZ_RES_LOW: %s", esp_err_to_name(error));
-        return error;
-    }
+    for (int i = 0; i < 4; i++) {
+        // Primeras 3 iteraciones leo angulo y en 4ta leo CRC
+        error = mt6835_transmit(mt6835Handle, dev, &operacion);
 
-    abzResLow = operacion.rx_data[0];
-    
-    // Una vez leido el registro, lo modifico
-    // Se toma que cualquier numero > 0 en abzSwap pondra en 1 el bit del registro
-    abzResLow = (abzSwap > 0) ? (abzResLow | 0x01) : (abzResLow & 0xFE);
+        if (error != ESP_OK) {
+            ESP_LOGE(tag, "Error al leer registro 0x%03X: %s", operacion.addr+i, esp_err_to_name(error));
+            return error;
+        }
 
-    operacion.cmd = WRITE;
-    
-    operacion.tx_data[0] = abzResLow;
+        regRx = operacion.rx_data[0];
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+        if (i < 3) {
+            temp |= (regRx << (16 - 8*i));
+        }
 
-    if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al escribir ABZ_RES_LOW: %s", esp_err_to_name(error));
-        return error;
+        operacion.addr++;
+        operacion.user = NULL;
+    }
+
+    if (dev != NULL) {
+        stamp.fin = 0;
+        mt6835_timing_update(dev, &stamp, inicio, esp_timer_get_time());
+
+        // Cada READ vuelve a congelar el angulo, asi que el CRC de la 4ta lectura no corresponde a los
+        // bytes anteriores: solo se cuentan los bits de estado, el CRC se verifica con la lectura burst
+        mt6835_fault_update(dev, temp, 0);
+        temp = mt6835_correct(dev, temp);
     }
 
-    printf("Escrito ABZ_SWAP: %d\n", abzSwap);
+    // Retorno 21 bits de angulo + 3 bits de estado, tener en cuenta al usar
+    *angle = temp;
 
     return ESP_OK;
 }
 
-esp_err_t mt6835_set_cur_position_zero(spi_device_handle_t *mt6835Handle) {
+esp_err_t mt6835_get_angle_burst(spi_device_handle_t *mt6835Handle, uint32_t *angle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_GET_ANGLE_BURST);
+
     esp_err_t error;
+    uint32_t temp = 0;
+    uint8_t crc = 0;
+    mt6835_stamp_t stamp = { 0 };
 
+    // Una sola transaccion: ANGLE_HIGH, ANGLE_MID, ANGLE_LOW y CRC (4 bytes, entran en rx_data)
     spi_transaction_t operacion = {
-        .cmd = SET_ZERO,
-        .addr = 0x000,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
+        .cmd = BURST_READ,
+        .addr = ANGLE_HIGH,
+        .length = 32,
+        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA,
+        .user = &stamp
     };
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    int64_t inicio = esp_timer_get_time();
 
-    if (error != ESP_OK || operacion.rx_data[0] != 0x55) {
-        ESP_LOGE(tag, "Problema al realizar cero en MT6835: %s", esp_err_to_name(error));
-        ESP_LOGE(tag, "ACK: 0x%02X != 0x55", operacion.rx_data[0]);
+    error = mt6835_transmit(mt6835Handle, dev, &operacion);
+
+    int64_t fin = esp_timer_get_time();
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error en lectura burst de angulo: %s", esp_err_to_name(error));
         return error;
     }
 
-    printf("Cero realizado\n");
+    temp = ((uint32_t)operacion.rx_data[0] << 16) | ((uint32_t)operacion.rx_data[1] << 8) | operacion.rx_data[2];
+    crc = operacion.rx_data[3];
 
-    return ESP_OK;
-}
+    uint32_t crcFail = calculate_crc_raw(temp) != crc;
 
-esp_err_t mt6835_set_zero(spi_device_handle_t *mt6835Handle, float angle) {
-    if (angle < 0.0 || angle > 360.0) {
-        ESP_LOGW(tag, "El angulo debe estar entre 0° y 360°.");
-        return ESP_FAIL;
+    if (dev != NULL) {
+        mt6835_fault_update(dev, temp, crcFail);
     }
 
-    esp_err_t error;
-
-    uint8_t zEdge = 0, zWidth = 0;
-
-    if (mt6835_get_z_edge(mt6835Handle, &zEdge) != ESP_OK) {
-        return ESP_FAIL;
+    // El CRC del MT6835 cubre los 24 bits (21 de angulo + 3 de estado)
+    if (crcFail) {
+        ESP_LOGE(tag, "CRC invalido: 0x%02X != 0x%02X", crc, calculate_crc_raw(temp));
+        return ESP_ERR_INVALID_CRC;
     }
 
-    if (mt6835_get_z_pulse_width(mt6835Handle, &zWidth) != ESP_OK) {
-        return ESP_FAIL;
+    // Los tiempos solo se actualizan con una muestra valida, predict_angle los usa junto con el angulo
+    if (dev != NULL) {
+        mt6835_timing_update(dev, &stamp, inicio, fin);
+        temp = mt6835_correct(dev, temp);
     }
 
-    uint16_t temp = angle * 4095 / 360;
-    printf("temp: %d\n", temp);
+    // Mismo formato que mt6835_get_angle: 21 bits de angulo + 3 bits de estado
+    *angle = temp;
 
-    spi_transaction_t operacion = {
-        .cmd = WRITE,
-        .addr = ZERO_HIGH,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
-    };
+    return ESP_OK;
+}
 
-    // ZERO_POS es de 12 bits, guardo los primeros 8 en el high byte
-    operacion.tx_data[0] = temp >> 4;
+// Tabla de CRC8 con polinomio 0x07, init 0x00, sin reflejar ni XOR final
+// Obtenida del mismo algoritmo bit a bit de https://github.com/simplefoc/Arduino-FOC-drivers/blob/master/src/encoders/mt6835/MT6835.cpp
+static const uint8_t crcTable[256] = {
+    0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15, 0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
+    0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65, 0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D,
+    0xE0, 0xE7, 0xEE, 0xE9, 0xFC, 0xFB, 0xF2, 0xF5, 0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
+    0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85, 0xA8, 0xAF, 0xA6, 0xA1, 0xB4, 0xB3, 0xBA, 0xBD,
+    0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2, 0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA,
+    0xB7, 0xB0, 0xB9, 0xBE, 0xAB, 0xAC, 0xA5, 0xA2, 0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
+    0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32, 0x1F, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0D, 0x0A,
+    0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42, 0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A,
+    0x89, 0x8E, 0x87, 0x80, 0x95, 0x92, 0x9B, 0x9C, 0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
+    0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC, 0xC1, 0xC6, 0xCF, 0xC8, 0xDD, 0xDA, 0xD3, 0xD4,
+    0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C, 0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44,
+    0x19, 0x1E, 0x17, 0x10, 0x05, 0x02, 0x0B, 0x0C, 0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
+    0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B, 0x76, 0x71, 0x78, 0x7F, 0x6A, 0x6D, 0x64, 0x63,
+    0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B, 0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13,
+    0xAE, 0xA9, 0xA0, 0xA7, 0xB2, 0xB5, 0xBC, 0xBB, 0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
+    0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB, 0xE6, 0xE1, 0xE8, 0xEF, 0xFA, 0xFD, 0xF4, 0xF3,
+};
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+uint8_t calculate_crc(uint32_t angle) {
+    // El CRC usado es distinto de los CRC8 estandar
+    // Recibe solo los 21 bits de angulo, los bits de estado se toman como 0
+    return calculate_crc_raw((angle << 3) & 0xFFFFFF);
+}
 
-    if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al escribir ZERO_HIGH: %s", esp_err_to_name(error));
-        return error;
+uint8_t calculate_crc_raw(uint32_t raw) {
+    // Igual que calculate_crc pero sobre la palabra cruda de 24 bits (ANGLE_HIGH, ANGLE_MID, ANGLE_LOW),
+    // es decir incluyendo los 3 bits de estado. Un acceso a tabla por byte en vez de 8 iteraciones
+    uint8_t crc = crcTable[(raw >> 16) & 0xFF];
+
+    crc = crcTable[crc ^ ((raw >> 8) & 0xFF)];
+    crc = crcTable[crc ^ (raw & 0xFF)];
+
+    return crc;
+}
+
+uint32_t mt6835_check_crc_batch(const uint32_t *raw, const uint8_t *crc, uint32_t count, uint32_t *failBitmap) {
+    uint32_t fails = 0;
+
+    // failBitmap debe tener (count + 31) / 32 palabras, bit i en 1 = muestra i con CRC invalido
+    for (uint32_t i = 0; i < (count + 31) / 32; i++) {
+        failBitmap[i] = 0;
     }
 
-    // Bitshift para bits de z edge y z pulse width
-    temp <<= 4;
-    // Bit de z edge
-    temp = (zEdge > 0) ? (temp | 0x08) : (temp & 0xF7);
-    // Bits de z pulse width
-    temp |= zWidth;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t fail = calculate_crc_raw(raw[i]) != crc[i];
+
+        failBitmap[i >> 5] |= fail << (i & 31);
+        fails += fail;
+    }
+
+    return fails;
+}
 
-    operacion.addr = ZERO_LOW;
+esp_err_t mt6835_program_eeprom(spi_device_handle_t *mt6835Handle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_PROGRAM_EEPROM);
 
-    operacion.tx_data[0] = temp;
+    esp_err_t error;
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    // Graba los registros actuales y bloquea la tarea hasta verificar, usar mt6835_eeprom_start para no bloquear
+    error = mt6835_eeprom_start(mt6835Handle, NULL);
 
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al escribir ZERO_LOW: %s", esp_err_to_name(error));
         return error;
     }
 
-    printf("Cero seteado en: %f\n", temp * 0.088);
-
-    return ESP_OK;
-    
+    return mt6835_eeprom_complete(mt6835Handle);
 }
 
-esp_err_t mt6835_get_z_edge(spi_device_handle_t *mt6835Handle, uint8_t *zEdge) {
+esp_err_t mt6835_get_abz_res(spi_device_handle_t *mt6835Handle, uint16_t *abzRes) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_GET_ABZ_RES);
+
     esp_err_t error;
+    uint8_t high = 0, low = 0;
 
-    spi_transaction_t operacion = {
-        .cmd = READ,
-        .addr = ZERO_LOW,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
-    };
+    // Primero leo BYTE HIGH (0x007) y luego leo BYTE LOW (0x008)
+    error = mt6835_read_reg(mt6835Handle, dev, ABZ_RES_HIGH, &high);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer resolucion (0x%03X) ABZ: %s", ABZ_RES_HIGH, esp_err_to_name(error));
+        return error;
+    }
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    error = mt6835_read_reg(mt6835Handle, dev, ABZ_RES_LOW, &low);
 
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al leer ZERO_LOW: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "Error al leer resolucion (0x%03X) ABZ: %s", ABZ_RES_LOW, esp_err_to_name(error));
         return error;
     }
 
-    *zEdge = (operacion.rx_data[0] & 0x08) >> 3;
+    // Elimino bits ABZ_OFF y ABZ_SWAP y +1 debido a que ppr = registro + 1
+    *abzRes = (((((uint16_t)high << 8) | low) >> 2) + 1) & 0x3FFF;
 
-    printf("Z_EDGE: %d\n0: Flanco de subida alineado con 0°\n1: Flanco de bajada alineado con 0°", *zEdge);
+    MT6835_TRACE(MT6835_EVT_GET_ABZ_RES, ABZ_RES_HIGH, *abzRes);
+    MT6835_PRINTF("Leido ABZ_RES: %d\n", *abzRes);
 
     return ESP_OK;
 }
 
-esp_err_t mt6835_set_z_edge(spi_device_handle_t *mt6835Handle, uint8_t zEdge) {
+esp_err_t mt6835_set_abz_res(spi_device_handle_t *mt6835Handle, uint16_t abzRes) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_SET_ABZ_RES);
+
+    if (abzRes == 0) {
+        ESP_LOGW(tag, "Resolucion minima: 1 ppr");
+        return ESP_FAIL;
+    }
+
     esp_err_t error;
 
-    uint8_t temp = 0;
+    uint8_t abzResLow = 0, temp = 0;
 
-    // Primero leo ZERO_LOW para no pisar bits de ZERO_POS y Z_WIDTH
-    spi_transaction_t operacion = {
-        .cmd = READ,
-        .addr = ZERO_LOW,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
-    };
+    // Primero leo ABZ_RES_LOW para no pisar ABZ_OFF y ABZ_SWAP (sin transaccion si esta en cache)
+    error = mt6835_read_reg(mt6835Handle, dev, ABZ_RES_LOW, &abzResLow);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer ABZ_RES_LOW: %s", esp_err_to_name(error));
+        return error;
+    }
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    // High byte del registro
+    error = mt6835_write_reg(mt6835Handle, dev, ABZ_RES_HIGH, ((abzRes-1) >> 6) & 0x00FF);
 
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al leer ZERO_LOW: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "Error al escribir resolucion (0x%03X) ABZ: %s", ABZ_RES_HIGH, esp_err_to_name(error));
         return error;
     }
 
-    temp = operacion.rx_data[0];
+    // Debo restar 1 por que los ppr = valor en registro + 1, por ejemplo, si el registro esta todo en 0, es 1 ppr
+    temp = ((abzRes-1) << 2) & 0x00FF;
+    // Conservo abzOff y abzSwap de ABZ_RES_LOW
+    temp |= abzResLow & 0x03;
 
-    // Borro bit de z edge
-    temp &= 0xF7;
-    // Pongo bit en 1 para todo zEdge > 0
-    temp = (zEdge > 0) ? (temp | 0x08) : (temp);
+    error = mt6835_write_reg(mt6835Handle, dev, ABZ_RES_LOW, temp);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al escribir resolucion (0x%03X) ABZ: %s", ABZ_RES_LOW, esp_err_to_name(error));
+        return error;
+    }
+
+    MT6835_TRACE(MT6835_EVT_SET_ABZ_RES, ABZ_RES_HIGH, abzRes);
+    MT6835_PRINTF("Escrito ABZ_RES: %d\n", abzRes);
+
+    return ESP_OK;
+}
 
-    operacion.cmd = WRITE;
+esp_err_t mt6835_get_abz_off(spi_device_handle_t *mt6835Handle, uint8_t *abzOff) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_GET_ABZ_OFF);
 
-    operacion.tx_data[0] = temp;
+    esp_err_t error;
+    uint8_t abzResLow = 0;
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    error = mt6835_read_reg(mt6835Handle, dev, ABZ_RES_LOW, &abzResLow);
 
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al escribir ZERO_LOW: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "Error al leer ABZ_OFF: %s", esp_err_to_name(error));
         return error;
     }
 
-    printf("Z_EDGE seteado: %d\n0: Flanco de subida alineado con 0°\n1: Flanco de bajada alineado con 0°", (temp & 0x08) >> 3);
+    *abzOff = (abzResLow & 0x02) >> 1;
+
+    MT6835_TRACE(MT6835_EVT_GET_ABZ_OFF, ABZ_RES_LOW, *abzOff);
+    MT6835_PRINTF("Leido ABZ_OFF: %d\n", *abzOff);
 
     return ESP_OK;
 }
 
-esp_err_t mt6835_get_z_pulse_width(spi_device_handle_t *mt6835Handle, uint8_t *zWidth) {
-    esp_err_t error;
+esp_err_t mt6835_set_abz_off(spi_device_handle_t *mt6835Handle, uint8_t abzOff) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_SET_ABZ_OFF);
 
-    spi_transaction_t operacion = {
-        .cmd = READ,
-        .addr = ZERO_LOW,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
-    };
+    esp_err_t error;
+    uint8_t abzResLow = 0;
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    // Primero debo leer ABZ_RES_LOW para no pisar bits de ABZ_RES ni ABZ_SWAP
+    error = mt6835_read_reg(mt6835Handle, dev, ABZ_RES_LOW, &abzResLow);
 
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al leer ZERO_LOW: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "Error al leer ABZ_RES_LOW: %s", esp_err_to_name(error));
         return error;
     }
+    
+    // Una vez leido el registro, lo modifico
+    // Se toma que cualquier numero > 0 en abzOff pondra en 1 el bit del registro
+    abzResLow = (abzOff > 0) ? (abzResLow | 0x02) : (abzResLow & 0xFD);
 
-    *zWidth = operacion.rx_data[0] & 0x07;
+    error = mt6835_write_reg(mt6835Handle, dev, ABZ_RES_LOW, abzResLow);
 
-    switch (*zWidth) {
-        case 0:
-        case 1:
-        case 2:
-        case 3:
-        case 4:
-            printf("Ancho de pulso de Z: %d LSB\n", 1 << *zWidth);
-            break;
-        case 5:
-            printf("Ancho de pulso de Z: 60°\n");
-            break;
-        case 6:
-            printf("Ancho de pulso de Z: 120°\n");
-            break;
-        case 7:
-            printf("Ancho de pulso de Z: 180°\n");
-            break;
-        default:
-            break;
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al escribir ABZ_RES_LOW: %s", esp_err_to_name(error));
+        return error;
     }
 
+    MT6835_TRACE(MT6835_EVT_SET_ABZ_OFF, ABZ_RES_LOW, abzOff);
+    MT6835_PRINTF("Escrito ABZ_OFF: %d\n", abzOff);
+
     return ESP_OK;
 }
 
-esp_err_t mt6835_set_z_pulse_width(spi_device_handle_t *mt6835Handle, uint8_t zWidth) {
-    if (zWidth > 0x07) {
-        ESP_LOGW(tag, "El valor del registro Z_WIDTH debe estar entre 0 y 7");
-        return ESP_FAIL;
-    }
+esp_err_t mt6835_get_abz_swap(spi_device_handle_t *mt6835Handle, uint8_t *abzSwap) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_GET_ABZ_SWAP);
 
     esp_err_t error;
+    uint8_t abzResLow = 0;
 
-    uint8_t temp = 0;
-
-    // Primero leo ZERO_LOW para no pisar bits de ZERO_POS y Z_EDGE
-    spi_transaction_t operacion = {
-        .cmd = READ,
-        .addr = ZERO_LOW,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
-    };
-
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    error = mt6835_read_reg(mt6835Handle, dev, ABZ_RES_LOW, &abzResLow);
 
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al leer ZERO_LOW: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "Error al leer ABZ_SWAP: %s", esp_err_to_name(error));
         return error;
     }
 
-    temp = operacion.rx_data[0];
+    *abzSwap = abzResLow & 0x01;
 
-    // Borro bits de z width
-    temp &= 0xF8;
-    // Como los bits estan en 0 solo hago un OR
-    temp |= zWidth;
+    MT6835_TRACE(MT6835_EVT_GET_ABZ_SWAP, ABZ_RES_LOW, *abzSwap);
+    MT6835_PRINTF("Leido ABZ_SWAP: %d\n", *abzSwap);
+
+    return ESP_OK;
+}
 
-    operacion.cmd = WRITE;
+esp_err_t mt6835_set_abz_swap(spi_device_handle_t *mt6835Handle, uint8_t abzSwap) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_SET_ABZ_SWAP);
 
-    operacion.tx_data[0] = temp;
+    esp_err_t error;
+    uint8_t abzResLow = 0;
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    // Primero debo leer ABZ_RES_LOW para no pisar bits de ABZ_RES ni ABZ_OFF
+    error = mt6835_read_reg(mt6835Handle, dev, ABZ_RES_LOW, &abzResLow);
 
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al escribir ZERO_LOW: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "Error al leer ABZ_RES_LOW: %s", esp_err_to_name(error));
+        return error;
+    }
+    
+    // Una vez leido el registro, lo modifico
+    // Se toma que cualquier numero > 0 en abzSwap pondra en 1 el bit del registro
+    abzResLow = (abzSwap > 0) ? (abzResLow | 0x01) : (abzResLow & 0xFE);
+
+    error = mt6835_write_reg(mt6835Handle, dev, ABZ_RES_LOW, abzResLow);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al escribir ABZ_RES_LOW: %s", esp_err_to_name(error));
         return error;
     }
 
-    printf("Z_WIDTH seteado: %d\n", (temp & 0x08) >> 3);
+    MT6835_TRACE(MT6835_EVT_SET_ABZ_SWAP, ABZ_RES_LOW, abzSwap);
+    MT6835_PRINTF("Escrito ABZ_SWAP: %d\n", abzSwap);
 
     return ESP_OK;
 }
 
-esp_err_t mt6835_get_z_phase(spi_device_handle_t *mt6835Handle, uint8_t *zPhase) {
+esp_err_t mt6835_set_cur_position_zero(spi_device_handle_t *mt6835Handle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_SET_CUR_POSITION_ZERO);
+
     esp_err_t error;
 
     spi_transaction_t operacion = {
-        .cmd = READ,
-        .addr = UVW_CONF,
+        .cmd = SET_ZERO,
+        .addr = 0x000,
         .length = 24,
         .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
     };
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    error = mt6835_transmit(mt6835Handle, dev, &operacion);
 
-    if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al leer UVW_CONF: %s", esp_err_to_name(error));
+    // El MT6835 reescribe ZERO_HIGH y ZERO_LOW, la cache de esos registros deja de valer
+
+    if (dev != NULL) {
+        dev->valid &= ~((1 << (ZERO_HIGH - USER_ID)) | (1 << (ZERO_LOW - USER_ID)));
+        dev->sinGrabar = 1;
+    }
+
+    if (error != ESP_OK || operacion.rx_data[0] != 0x55) {
+        ESP_LOGE(tag, "Problema al realizar cero en MT6835: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "ACK: 0x%02X != 0x55", operacion.rx_data[0]);
         return error;
     }
 
-    *zPhase = (operacion.rx_data[0] & 0xC0) >> 6;
+    // La posicion actual ya es el cero completo, no queda resto por software
+    if (dev != NULL) {
+        dev->zeroOffset = 0;
+    }
 
-    printf("Z_PHASE: %d\n", *zPhase);
+    MT6835_TRACE(MT6835_EVT_SET_CUR_ZERO, ZERO_HIGH, 0);
+    MT6835_PRINTF("Cero realizado\n");
 
     return ESP_OK;
 }
 
-esp_err_t mt6835_set_z_phase(spi_device_handle_t *mt6835Handle, uint8_t zPhase) {
-    if (zPhase > 0x03) {
-        ESP_LOGW(tag, "El valor del registro Z_PHASE debe estar entre 0 y 3");
+esp_err_t mt6835_set_zero(spi_device_handle_t *mt6835Handle, float angle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_SET_ZERO);
+
+    if (angle < 0.0 || angle > 360.0) {
+        ESP_LOGW(tag, "El angulo debe estar entre 0° y 360°.");
         return ESP_FAIL;
     }
 
     esp_err_t error;
 
-    uint8_t temp;
-
-    // Primero leo UVW_CONF para no pisar bits UVW_MUX, UVW_OFF y UVW_RES
-    spi_transaction_t operacion = {
-        .cmd = READ,
-        .addr = UVW_CONF,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
-    };
+    uint8_t zeroLow = 0;
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    // Leo ZERO_LOW una sola vez para no pisar z edge y z pulse width
+    error = mt6835_read_reg(mt6835Handle, dev, ZERO_LOW, &zeroLow);
 
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al leer UVW_CONF: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "Error al leer ZERO_LOW: %s", esp_err_to_name(error));
         return error;
     }
 
-    temp = operacion.rx_data[0];
+    uint16_t temp = angle * 4095 / 360;
 
-    // Borro bits de Z_PHASE
-    temp &= 0x3F;
-    // Como los bits estan en 0 solo hago un OR, pero debo bitshiftear zPhase para alinear
-    temp |= (zPhase << 6);
+    // ZERO_POS es de 12 bits, guardo los primeros 8 en el high byte
+    error = mt6835_write_reg(mt6835Handle, dev, ZERO_HIGH, temp >> 4);
 
-    operacion.cmd = WRITE;
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al escribir ZERO_HIGH: %s", esp_err_to_name(error));
+        return error;
+    }
 
-    operacion.tx_data[0] = temp;
+    // Bitshift para bits de z edge y z pulse width
+    temp <<= 4;
+    // Bits de z edge y z pulse width
+    temp = (temp & 0xFFF0) | (zeroLow & 0x0F);
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    error = mt6835_write_reg(mt6835Handle, dev, ZERO_LOW, temp);
 
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al escribir UVW_CONF: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "Error al escribir ZERO_LOW: %s", esp_err_to_name(error));
         return error;
     }
 
-    printf("Z_PHASE grabado: %d\n", zPhase);
+    // El cero por software de set_zero_fine era relativo al ZERO_POS anterior
+    if (dev != NULL) {
+        dev->zeroOffset = 0;
+    }
+
+    MT6835_TRACE(MT6835_EVT_SET_ZERO, ZERO_HIGH, temp);
+    MT6835_PRINTF("Cero seteado en: %f\n", temp * 0.088);
 
     return ESP_OK;
+    
 }
 
-esp_err_t mt6835_get_abz_lead(spi_device_handle_t *mt6835Handle, uint8_t *abLead) {
-    esp_err_t error;
+esp_err_t mt6835_get_z_edge(spi_device_handle_t *mt6835Handle, uint8_t *zEdge) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_GET_Z_EDGE);
 
-    spi_transaction_t operacion = {
-        .cmd = READ,
-        .addr = HYST,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
-    };
+    esp_err_t error;
+    uint8_t zeroLow = 0;
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    error = mt6835_read_reg(mt6835Handle, dev, ZERO_LOW, &zeroLow);
 
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al leer HYST: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "Error al leer ZERO_LOW: %s", esp_err_to_name(error));
         return error;
     }
 
-    *abLead = (operacion.rx_data[0] & 0x08) >> 3;
+    *zEdge = (zeroLow & 0x08) >> 3;
 
-    switch (*abLead) {
-        case CCW_BA:
-            printf("B adelanta A en giro antihorario\n");
-            break;
-        case CCW_AB:
-            printf("A adelanta B en giro antihorario\n");
-            break;
-        default:
-            printf("Registo mal leido\n");
-            return ESP_FAIL;
-    }
+    MT6835_TRACE(MT6835_EVT_GET_Z_EDGE, ZERO_LOW, *zEdge);
+    MT6835_PRINTF("Z_EDGE: %d\n0: Flanco de subida alineado con 0°\n1: Flanco de bajada alineado con 0°", *zEdge);
 
     return ESP_OK;
 }
 
-esp_err_t mt6835_set_abz_lead(spi_device_handle_t *mt6835Handle, uint8_t abLead) {
+esp_err_t mt6835_set_z_edge(spi_device_handle_t *mt6835Handle, uint8_t zEdge) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_SET_Z_EDGE);
+
     esp_err_t error;
 
     uint8_t temp = 0;
 
-    // Primero leo registro para no pisar HYST y parte prioritaria
-    spi_transaction_t operacion = {
-        .cmd = READ,
-        .addr = HYST,
-        .length = 24,
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
-    };
-
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    // Primero leo ZERO_LOW para no pisar bits de ZERO_POS y Z_WIDTH
+    error = mt6835_read_reg(mt6835Handle, dev, ZERO_LOW, &temp);
 
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al leer HYST: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "Error al leer ZERO_LOW: %s", esp_err_to_name(error));
         return error;
     }
 
-    temp = operacion.rx_data[0];
-
-    // Pongo en 0 el bit de ROT_DIR
+    // Borro bit de z edge
     temp &= 0xF7;
-    // Si abLead > 0, pongo el bit en 1 (CCW_AB)
-    temp = (abLead > 0) ? (temp | CCW_AB) : (temp);
-
-    operacion.cmd = WRITE;
-
-    operacion.tx_data[0] = temp;
+    // Pongo bit en 1 para todo zEdge > 0
+    temp = (zEdge > 0) ? (temp | 0x08) : (temp);
 
-    error = spi_device_transmit(*mt6835Handle, &operacion);
+    error = mt6835_write_reg(mt6835Handle, dev, ZERO_LOW, temp);
 
     if (error != ESP_OK) {
-        ESP_LOGE(tag, "Error al escribir HYST: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "Error al escribir ZERO_LOW: %s", esp_err_to_name(error));
         return error;
     }
 
-    switch (abLead) {
-        case CCW_BA:
-            printf("B adelanta A en giro antihorario\n");
-            break;
-        case CCW_AB:
-            printf("A adelanta B en giro antihorario\n");
-            break;
-        default:
-            return ESP_FAIL;
-    }
+    MT6835_TRACE(MT6835_EVT_SET_Z_EDGE, ZERO_LOW, temp);
+    MT6835_PRINTF("Z_EDGE seteado: %d\n0: Flanco de subida alineado con 0°\n1: Flanco de bajada alineado con 0°", (temp & 0x08) >> 3);
 
     return ESP_OK;
 }
 
+esp_err_t mt6835_get_z_pulse_width(spi_device_handle_t *mt6835Handle, uint8_t *zWidth) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_GET_Z_PULSE_WIDTH);
+
+    esp_err_t error;
+    uint8_t zeroLow = 0;
 
+    error = mt6835_read_reg(mt6835Handle, dev, ZERO_LOW, &zeroLow);
 
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer ZERO_LOW: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    *zWidth = zeroLow & 0x07;
+
+    MT6835_TRACE(MT6835_EVT_GET_Z_WIDTH, ZERO_LOW, *zWidth);
+    switch (*zWidth) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+        case 4:
+            MT6835_PRINTF("Ancho de pulso de Z: %d LSB\n", 1 << *zWidth);
+            break;
+        case 5:
+            MT6835_PRINTF("Ancho de pulso de Z: 60°\n");
+            break;
+        case 6:
+            MT6835_PRINTF("Ancho de pulso de Z: 120°\n");
+            break;
+        case 7:
+            MT6835_PRINTF("Ancho de pulso de Z: 180°\n");
+            break;
+        default:
+            break;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_set_z_pulse_width(spi_device_handle_t *mt6835Handle, uint8_t zWidth) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_SET_Z_PULSE_WIDTH);
+
+    if (zWidth > 0x07) {
+        ESP_LOGW(tag, "El valor del registro Z_WIDTH debe estar entre 0 y 7");
+        return ESP_FAIL;
+    }
+
+    esp_err_t error;
+
+    uint8_t temp = 0;
+
+    // Primero leo ZERO_LOW para no pisar bits de ZERO_POS y Z_EDGE
+    error = mt6835_read_reg(mt6835Handle, dev, ZERO_LOW, &temp);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer ZERO_LOW: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    // Borro bits de z width
+    temp &= 0xF8;
+    // Como los bits estan en 0 solo hago un OR
+    temp |= zWidth;
+
+    error = mt6835_write_reg(mt6835Handle, dev, ZERO_LOW, temp);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al escribir ZERO_LOW: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    MT6835_TRACE(MT6835_EVT_SET_Z_WIDTH, ZERO_LOW, temp);
+    MT6835_PRINTF("Z_WIDTH seteado: %d\n", temp & 0x07);
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_get_z_phase(spi_device_handle_t *mt6835Handle, uint8_t *zPhase) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_GET_Z_PHASE);
+
+    esp_err_t error;
+    uint8_t uvwConf = 0;
+
+    error = mt6835_read_reg(mt6835Handle, dev, UVW_CONF, &uvwConf);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer UVW_CONF: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    *zPhase = (uvwConf & 0xC0) >> 6;
+
+    MT6835_TRACE(MT6835_EVT_GET_Z_PHASE, UVW_CONF, *zPhase);
+    MT6835_PRINTF("Z_PHASE: %d\n", *zPhase);
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_set_z_phase(spi_device_handle_t *mt6835Handle, uint8_t zPhase) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_SET_Z_PHASE);
+
+    if (zPhase > 0x03) {
+        ESP_LOGW(tag, "El valor del registro Z_PHASE debe estar entre 0 y 3");
+        return ESP_FAIL;
+    }
+
+    esp_err_t error;
+
+    uint8_t temp;
+
+    // Primero leo UVW_CONF para no pisar bits UVW_MUX, UVW_OFF y UVW_RES
+    error = mt6835_read_reg(mt6835Handle, dev, UVW_CONF, &temp);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer UVW_CONF: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    // Borro bits de Z_PHASE
+    temp &= 0x3F;
+    // Como los bits estan en 0 solo hago un OR, pero debo bitshiftear zPhase para alinear
+    temp |= (zPhase << 6);
+
+    error = mt6835_write_reg(mt6835Handle, dev, UVW_CONF, temp);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al escribir UVW_CONF: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    MT6835_TRACE(MT6835_EVT_SET_Z_PHASE, UVW_CONF, zPhase);
+    MT6835_PRINTF("Z_PHASE grabado: %d\n", zPhase);
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_get_abz_lead(spi_device_handle_t *mt6835Handle, uint8_t *abLead) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_GET_ABZ_LEAD);
+
+    esp_err_t error;
+    uint8_t hyst = 0;
+
+    error = mt6835_read_reg(mt6835Handle, dev, HYST, &hyst);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer HYST: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    *abLead = (hyst & 0x08) >> 3;
+
+    MT6835_TRACE(MT6835_EVT_GET_ABZ_LEAD, HYST, *abLead);
+    switch (*abLead) {
+        case CCW_BA:
+            MT6835_PRINTF("B adelanta A en giro antihorario\n");
+            break;
+        case CCW_AB:
+            MT6835_PRINTF("A adelanta B en giro antihorario\n");
+            break;
+        default:
+            MT6835_PRINTF("Registo mal leido\n");
+            return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_set_abz_lead(spi_device_handle_t *mt6835Handle, uint8_t abLead) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_SET_ABZ_LEAD);
+
+    esp_err_t error;
+
+    uint8_t temp = 0;
+
+    // Primero leo registro para no pisar HYST y parte prioritaria
+    error = mt6835_read_reg(mt6835Handle, dev, HYST, &temp);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer HYST: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    // Pongo en 0 el bit de ROT_DIR
+    temp &= 0xF7;
+    // Si abLead > 0, pongo el bit en 1 (CCW_AB)
+    temp = (abLead > 0) ? (temp | CCW_AB) : (temp);
+
+    error = mt6835_write_reg(mt6835Handle, dev, HYST, temp);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al escribir HYST: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    MT6835_TRACE(MT6835_EVT_SET_ABZ_LEAD, HYST, temp);
+    switch (abLead) {
+        case CCW_BA:
+            MT6835_PRINTF("B adelanta A en giro antihorario\n");
+            break;
+        case CCW_AB:
+            MT6835_PRINTF("A adelanta B en giro antihorario\n");
+            break;
+        default:
+            return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_get_bw(spi_device_handle_t *mt6835Handle, uint8_t *bw) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_GET_BW);
+
+    esp_err_t error;
+    uint8_t temp = 0;
+
+    error = mt6835_read_reg(mt6835Handle, dev, BW, &temp);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer BW: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    *bw = temp & 0x07;
+
+    MT6835_TRACE(MT6835_EVT_GET_BW, BW, *bw);
+    MT6835_PRINTF("BW: %d\n", *bw);
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_set_bw(spi_device_handle_t *mt6835Handle, uint8_t bw) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_SET_BW);
+
+    if (bw > 0x07) {
+        ESP_LOGW(tag, "El valor del registro BW debe estar entre 0 y 7");
+        return ESP_FAIL;
+    }
+
+    esp_err_t error;
+    uint8_t temp;
+
+    // Primero leo BW para no pisar los bits reservados
+    error = mt6835_read_reg(mt6835Handle, dev, BW, &temp);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer BW: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    temp = (temp & 0xF8) | bw;
+
+    error = mt6835_write_reg(mt6835Handle, dev, BW, temp);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al escribir BW: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    MT6835_TRACE(MT6835_EVT_SET_BW, BW, bw);
+    MT6835_PRINTF("BW grabado: %d\n", bw);
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_get_hyst(spi_device_handle_t *mt6835Handle, uint8_t *hyst) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_GET_HYST);
+
+    esp_err_t error;
+    uint8_t temp = 0;
+
+    error = mt6835_read_reg(mt6835Handle, dev, HYST, &temp);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer HYST: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    *hyst = temp & 0x07;
+
+    MT6835_TRACE(MT6835_EVT_GET_HYST, HYST, *hyst);
+    MT6835_PRINTF("HYST: %d\n", *hyst);
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_set_hyst(spi_device_handle_t *mt6835Handle, uint8_t hyst) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_SET_HYST);
+
+    if (hyst > 0x07) {
+        ESP_LOGW(tag, "El valor del registro HYST debe estar entre 0 y 7");
+        return ESP_FAIL;
+    }
+
+    esp_err_t error;
+    uint8_t temp;
+
+    // Primero leo HYST para no pisar ROT_DIR
+    error = mt6835_read_reg(mt6835Handle, dev, HYST, &temp);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer HYST: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    temp = (temp & 0xF8) | hyst;
+
+    error = mt6835_write_reg(mt6835Handle, dev, HYST, temp);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al escribir HYST: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    MT6835_TRACE(MT6835_EVT_SET_HYST, HYST, hyst);
+    MT6835_PRINTF("HYST grabado: %d\n", hyst);
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_config_read(spi_device_handle_t *mt6835Handle, mt6835_config_t *config) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_CONFIG_READ);
+
+    esp_err_t error;
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Una sola lectura burst si la cache no esta completa
+    if ((dev->valid & MT6835_CACHE_MASK) != MT6835_CACHE_MASK) {
+        error = mt6835_cache_refresh(mt6835Handle);
+
+        if (error != ESP_OK) {
+            return error;
+        }
+    }
+
+    uint8_t *regs = dev->regs;
+    uint16_t abz = ((uint16_t)regs[ABZ_RES_HIGH - USER_ID] << 6) | (regs[ABZ_RES_LOW - USER_ID] >> 2);
+
+    config->abzRes = abz + 1;
+    config->abzOff = (regs[ABZ_RES_LOW - USER_ID] & 0x02) >> 1;
+    config->abzSwap = regs[ABZ_RES_LOW - USER_ID] & 0x01;
+    config->zeroPos = ((uint16_t)regs[ZERO_HIGH - USER_ID] << 4) | (regs[ZERO_LOW - USER_ID] >> 4);
+    config->zEdge = (regs[ZERO_LOW - USER_ID] & 0x08) >> 3;
+    config->zWidth = regs[ZERO_LOW - USER_ID] & 0x07;
+    config->zPhase = (regs[UVW_CONF - USER_ID] & 0xC0) >> 6;
+    config->rotDir = (regs[HYST - USER_ID] & 0x08) >> 3;
+    config->hyst = regs[HYST - USER_ID] & 0x07;
+    config->bw = regs[BW - USER_ID] & 0x07;
+    config->autocalFreq = (regs[AUTOCAL_FREQ - USER_ID] & 0x70) >> 4;
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_config_apply(spi_device_handle_t *mt6835Handle, const mt6835_config_t *config) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_CONFIG_APPLY);
+
+    if (config->abzRes == 0 || config->abzRes > 16384 || config->zeroPos > 0x0FFF || config->zWidth > 0x07 ||
+        config->zPhase > 0x03 || config->hyst > 0x07 || config->bw > 0x07 || config->autocalFreq > 0x07) {
+        ESP_LOGW(tag, "Configuracion fuera de rango");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t error;
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if ((dev->valid & MT6835_CACHE_MASK) != MT6835_CACHE_MASK) {
+        error = mt6835_cache_refresh(mt6835Handle);
+
+        if (error != ESP_OK) {
+            return error;
+        }
+    }
+
+    // Imagen nueva de ABZ_RES_HIGH..BW partiendo del estado actual para no pisar campos que no estan en config
+    uint8_t imagen[BW - ABZ_RES_HIGH + 1];
+
+    for (int i = 0; i < BW - ABZ_RES_HIGH + 1; i++) {
+        imagen[i] = dev->regs[ABZ_RES_HIGH - USER_ID + i];
+    }
+
+    imagen[ABZ_RES_HIGH - ABZ_RES_HIGH] = ((config->abzRes - 1) >> 6) & 0xFF;
+    imagen[ABZ_RES_LOW - ABZ_RES_HIGH] = (((config->abzRes - 1) << 2) & 0xFC) | ((config->abzOff > 0) << 1) | (config->abzSwap > 0);
+    imagen[ZERO_HIGH - ABZ_RES_HIGH] = config->zeroPos >> 4;
+    imagen[ZERO_LOW - ABZ_RES_HIGH] = ((config->zeroPos << 4) & 0xF0) | ((config->zEdge > 0) << 3) | config->zWidth;
+    imagen[UVW_CONF - ABZ_RES_HIGH] = (imagen[UVW_CONF - ABZ_RES_HIGH] & 0x3F) | (config->zPhase << 6);
+    imagen[HYST - ABZ_RES_HIGH] = (imagen[HYST - ABZ_RES_HIGH] & 0xF0) | ((config->rotDir > 0) << 3) | config->hyst;
+    imagen[AUTOCAL_FREQ - ABZ_RES_HIGH] = (imagen[AUTOCAL_FREQ - ABZ_RES_HIGH] & 0x8F) | (config->autocalFreq << 4);
+    imagen[BW - ABZ_RES_HIGH] = (imagen[BW - ABZ_RES_HIGH] & 0xF8) | config->bw;
+
+    // El MT6835 no tiene escritura burst: se escribe byte a byte y mt6835_write_reg omite los que no cambian
+    for (uint16_t addr = ABZ_RES_HIGH; addr <= BW; addr++) {
+        if (!(MT6835_CACHE_MASK & (1 << (addr - USER_ID)))) {
+            continue;
+        }
+
+        error = mt6835_write_reg(mt6835Handle, dev, addr, imagen[addr - ABZ_RES_HIGH]);
+
+        if (error != ESP_OK) {
+            ESP_LOGE(tag, "Error al escribir registro 0x%03X: %s", addr, esp_err_to_name(error));
+            return error;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_fast_begin(spi_device_handle_t *mt6835Handle) {
+    esp_err_t error;
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (dev->busTomado) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Tomo el bus para este dispositivo, el resto de los dispositivos del host esperan hasta fast_end
+    error = transporte->acquire_bus(*mt6835Handle, portMAX_DELAY);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al tomar el bus SPI: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    dev->fastOp = (spi_transaction_t) {
+        .cmd = BURST_READ,
+        .addr = ANGLE_HIGH,
+        .length = 32,
+        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA,
+        .user = &dev->fastStamp
+    };
+
+    dev->busTomado = 1;
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_fast_get_angle(spi_device_handle_t *mt6835Handle, uint32_t *angle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_FAST_GET_ANGLE);
+
+    esp_err_t error;
+
+    if (dev == NULL || !dev->busTomado) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Transaccion por polling con el descriptor ya armado: sin interrupciones ni cambios de contexto
+    mt6835_count(dev, &dev->fastOp);
+
+    dev->fastStamp = (mt6835_stamp_t) { 0 };
+    int64_t inicio = esp_timer_get_time();
+
+    error = transporte->polling_transmit(*mt6835Handle, &dev->fastOp);
+
+    if (error != ESP_OK) {
+#if MT6835_STATS
+        dev->stats[dev->apiActual].errors++;
+#endif
+        return error;
+    }
+
+    int64_t fin = esp_timer_get_time();
+
+    uint32_t temp = ((uint32_t)dev->fastOp.rx_data[0] << 16) | ((uint32_t)dev->fastOp.rx_data[1] << 8) | dev->fastOp.rx_data[2];
+
+    uint32_t crcFail = calculate_crc_raw(temp) != dev->fastOp.rx_data[3];
+
+    mt6835_fault_update(dev, temp, crcFail);
+
+    if (crcFail) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    mt6835_timing_update(dev, &dev->fastStamp, inicio, fin);
+    temp = mt6835_correct(dev, temp);
+
+    *angle = temp;
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_fast_end(spi_device_handle_t *mt6835Handle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+
+    if (dev == NULL || !dev->busTomado) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    transporte->release_bus(*mt6835Handle);
+    dev->busTomado = 0;
+
+    return ESP_OK;
+}
+
+void mt6835_sched_init(mt6835_sched_t *sched) {
+    sched->ejes = 0;
+}
+
+esp_err_t mt6835_sched_add(mt6835_sched_t *sched, spi_device_handle_t *mt6835Handle) {
+    if (sched->ejes >= MT6835_SCHED_MAX_AXES) {
+        ESP_LOGW(tag, "Maximo de %d ejes por scheduler", MT6835_SCHED_MAX_AXES);
+        return ESP_ERR_NO_MEM;
+    }
+
+    sched->handles[sched->ejes] = mt6835Handle;
+    sched->operaciones[sched->ejes] = (spi_transaction_t) {
+        .cmd = BURST_READ,
+        .addr = ANGLE_HIGH,
+        .length = 32,
+        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
+    };
+    sched->ejes++;
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_sched_read(mt6835_sched_t *sched, mt6835_sched_sample_t *muestra) {
+    esp_err_t error = ESP_OK, resultado = ESP_OK;
+    spi_transaction_t *operacion;
+    mt6835_dev_t *devs[MT6835_SCHED_MAX_AXES];
+    uint32_t encoladas = 0;
+#if MT6835_STATS
+    // Cada eje es otro dispositivo: la pasada cuenta como una llamada en cada uno
+    mt6835_stats_scope_t scopes[MT6835_SCHED_MAX_AXES];
+#endif
+
+    for (uint32_t i = 0; i < sched->ejes; i++) {
+        devs[i] = mt6835_dev(sched->handles[i]);
+#if MT6835_STATS
+        scopes[i] = mt6835_stats_begin(devs[i], MT6835_API_SCHED_READ);
+#endif
+    }
+
+    // Encolo todos los ejes primero para que el driver los transmita uno detras de otro
+    for (uint32_t i = 0; i < sched->ejes; i++) {
+        sched->stamps[i] = (mt6835_stamp_t) { 0 };
+        sched->operaciones[i].user = &sched->stamps[i];
+
+        error = transporte->queue_trans(*sched->handles[i], &sched->operaciones[i], portMAX_DELAY);
+
+        if (error != ESP_OK) {
+            ESP_LOGE(tag, "Error al encolar lectura del eje %lu: %s", (unsigned long)i, esp_err_to_name(error));
+            break;
+        }
+
+        mt6835_count(devs[i], &sched->operaciones[i]);
+        encoladas++;
+    }
+
+    muestra->crcFail = 0;
+    // Los ejes que no se llegaron a encolar tambien quedan marcados
+    muestra->error = ((1UL << sched->ejes) - 1) & ~((1UL << encoladas) - 1);
+
+    // Los resultados salen en el orden en que se encolaron. Si un eje falla sigo retirando los demas,
+    // sus descriptores son de sched y la proxima pasada los volveria a encolar
+    for (uint32_t i = 0; i < encoladas; i++) {
+        if (transporte->get_trans_result(*sched->handles[i], &operacion, portMAX_DELAY) != ESP_OK) {
+            ESP_LOGE(tag, "Error al obtener lectura del eje %lu", (unsigned long)i);
+            muestra->error |= 1UL << i;
+            resultado = ESP_FAIL;
+#if MT6835_STATS
+            if (devs[i] != NULL) {
+                devs[i]->stats[devs[i]->apiActual].errors++;
+            }
+#endif
+            continue;
+        }
+
+        // Sin mt6835_spi_post_cb instalado el momento es el de retirar el resultado, no el de la transaccion
+        muestra->timestamp[i] = (sched->stamps[i].fin != 0) ? sched->stamps[i].fin : esp_timer_get_time();
+        muestra->raw[i] = ((uint32_t)operacion->rx_data[0] << 16) | ((uint32_t)operacion->rx_data[1] << 8) | operacion->rx_data[2];
+        uint32_t crcFail = calculate_crc_raw(muestra->raw[i]) != operacion->rx_data[3];
+
+        if (devs[i] != NULL) {
+            mt6835_fault_update(devs[i], muestra->raw[i], crcFail);
+
+            // Mismas correcciones por software que mt6835_get_angle, solo sobre lecturas validas
+            if (!crcFail) {
+                muestra->raw[i] = mt6835_correct(devs[i], muestra->raw[i]);
+            }
+        }
+
+        muestra->crcFail |= crcFail << i;
+    }
+
+    // Skew solo entre los ejes que completaron la transaccion, referido al primero de ellos
+    int64_t primero = 0, minimo = 0, maximo = 0;
+    uint8_t hayReferencia = 0;
+
+    for (uint32_t i = 0; i < sched->ejes; i++) {
+        if (muestra->error & (1UL << i)) {
+            muestra->raw[i] = 0;
+            muestra->timestamp[i] = 0;
+            muestra->skew[i] = 0;
+            continue;
+        }
+
+        if (!hayReferencia) {
+            primero = minimo = maximo = muestra->timestamp[i];
+            hayReferencia = 1;
+        }
+
+        muestra->skew[i] = muestra->timestamp[i] - primero;
+        minimo = (muestra->timestamp[i] < minimo) ? muestra->timestamp[i] : minimo;
+        maximo = (muestra->timestamp[i] > maximo) ? muestra->timestamp[i] : maximo;
+    }
+
+    muestra->maxSkew = maximo - minimo;
+
+#if MT6835_STATS
+    // En orden inverso por si el mismo dispositivo esta en mas de un eje
+    for (uint32_t i = sched->ejes; i > 0; i--) {
+        mt6835_stats_end(&scopes[i - 1]);
+    }
+#endif
+
+    if (resultado != ESP_OK) {
+        return resultado;
+    }
+
+    return error;
+}
+
+esp_err_t mt6835_nlc_read(spi_device_handle_t *mt6835Handle, uint8_t *tabla) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_NLC_READ);
+
+    esp_err_t error;
+
+    // Toda la tabla en una lectura burst
+    error = mt6835_read_block(mt6835Handle, dev, NLC_START, tabla, MT6835_NLC_SIZE);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer tabla NLC: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    return ESP_OK;
+}
+
+// Escribe los bytes de tabla que difieren de actual (no hay escritura burst)
+static esp_err_t mt6835_nlc_write_diff(spi_device_handle_t *mt6835Handle, mt6835_dev_t *dev, const uint8_t *actual, const uint8_t *tabla) {
+    esp_err_t error = ESP_OK;
+    spi_transaction_t operaciones[MT6835_NLC_QUEUE];
+    spi_transaction_t *operacion;
+    uint32_t enCola = 0, libre = 0;
+
+    for (uint16_t i = 0; i < MT6835_NLC_SIZE; i++) {
+        if (actual[i] == tabla[i]) {
+            continue;
+        }
+
+        // Con la ventana llena espero una escritura y reuso su descriptor
+        if (enCola == MT6835_NLC_QUEUE) {
+            error = transporte->get_trans_result(*mt6835Handle, &operacion, portMAX_DELAY);
+
+            if (error != ESP_OK) {
+                // No retorno: las demas escrituras siguen en cola apuntando a operaciones
+                ESP_LOGE(tag, "Error al escribir tabla NLC: %s", esp_err_to_name(error));
+                break;
+            }
+
+            enCola--;
+            libre = operacion - operaciones;
+        } else {
+            libre = enCola;
+        }
+
+        operaciones[libre] = (spi_transaction_t) {
+            .cmd = WRITE,
+            .addr = NLC_START + i,
+            .length = 24,
+            .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
+        };
+        operaciones[libre].tx_data[0] = tabla[i];
+
+        error = transporte->queue_trans(*mt6835Handle, &operaciones[libre], portMAX_DELAY);
+
+        if (error != ESP_OK) {
+            ESP_LOGE(tag, "Error al encolar escritura NLC 0x%03X: %s", NLC_START + i, esp_err_to_name(error));
+            break;
+        }
+
+        mt6835_count(dev, &operaciones[libre]);
+        enCola++;
+
+        if (dev != NULL) {
+            dev->sinGrabar = 1;
+        }
+    }
+
+    // Espero las escrituras pendientes antes de que operaciones salga de alcance, aunque alguna falle
+    for (; enCola > 0; enCola--) {
+        if (transporte->get_trans_result(*mt6835Handle, &operacion, portMAX_DELAY) != ESP_OK) {
+            ESP_LOGE(tag, "Error al completar escritura NLC");
+            error = ESP_FAIL;
+        }
+    }
+
+    return error;
+}
+
+esp_err_t mt6835_nlc_write(spi_device_handle_t *mt6835Handle, const uint8_t *tabla) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_NLC_WRITE);
+
+    esp_err_t error;
+    uint8_t actual[MT6835_NLC_SIZE];
+
+    // Leo la tabla actual para escribir solo los bytes que cambian
+    error = mt6835_nlc_read(mt6835Handle, actual);
+
+    if (error != ESP_OK) {
+        return error;
+    }
+
+    return mt6835_nlc_write_diff(mt6835Handle, dev, actual, tabla);
+}
+
+esp_err_t mt6835_nlc_enable(spi_device_handle_t *mt6835Handle, uint8_t nlcEn) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_NLC_ENABLE);
+
+    esp_err_t error;
+    uint8_t temp = 0;
+
+    // Primero leo PWM_CONF para no pisar la configuracion de PWM
+    error = mt6835_read_reg(mt6835Handle, dev, PWM_CONF, &temp);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer PWM_CONF: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    temp = (nlcEn > 0) ? (temp | 0x20) : (temp & 0xDF);
+
+    error = mt6835_write_reg(mt6835Handle, dev, PWM_CONF, temp);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al escribir PWM_CONF: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_nlc_calibrate(const uint32_t *raw, uint32_t cantidad, uint8_t armonicos, uint8_t *tabla) {
+#if !MT6835_NLC_LAYOUT
+    ESP_LOGW(tag, "Formato de tabla NLC sin confirmar, compilar con MT6835_NLC_LAYOUT 1 para usarlo");
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+    if (cantidad < 2 || armonicos == 0 || armonicos > MT6835_NLC_MAX_HARMONICS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Se corre una sola vez por encoder fuera del lazo de control, por eso usa double y libm
+    // 1) Desenrollo la captura para saber cuantas vueltas completas cubre
+    int64_t acumulado = 0;
+    uint32_t anterior = (raw[0] >> 3) & 0x1FFFFF;
+
+    for (uint32_t i = 1; i < cantidad; i++) {
+        uint32_t angulo = (raw[i] >> 3) & 0x1FFFFF;
+
+        acumulado += (int32_t)((angulo - anterior) << 11) >> 11;
+        anterior = angulo;
+    }
+
+    int64_t vueltas = ((acumulado < 0) ? -acumulado : acumulado) >> 21;
+
+    // Necesito vueltas completas para que los armonicos sean ortogonales
+    if (vueltas == 0) {
+        ESP_LOGW(tag, "La captura de calibracion debe cubrir al menos una vuelta");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Me quedo con las muestras de las vueltas completas
+    cantidad = (uint32_t)((double)(cantidad - 1) * (vueltas << 21) / ((acumulado < 0) ? -acumulado : acumulado)) + 1;
+
+    // 2) Recta de velocidad constante: la pendiente sale de los extremos (mismo angulo, mismo error)
+    //    y el origen del promedio, donde los armonicos de vueltas completas suman 0.
+    //    Un ajuste por minimos cuadrados absorberia parte del primer armonico
+    double sumY = 0;
+
+    acumulado = 0;
+    anterior = (raw[0] >> 3) & 0x1FFFFF;
+
+    for (uint32_t i = 0; i < cantidad; i++) {
+        uint32_t angulo = (raw[i] >> 3) & 0x1FFFFF;
+
+        acumulado += (int32_t)((angulo - anterior) << 11) >> 11;
+        anterior = angulo;
+
+        sumY += acumulado;
+    }
+
+    double pendiente = (double)acumulado / (cantidad - 1);
+    double origen = sumY / cantidad - pendiente * (cantidad - 1) / 2.0;
+
+    // 3) Error contra la recta proyectado en los primeros armonicos del angulo medido
+    double a[MT6835_NLC_MAX_HARMONICS] = { 0 }, b[MT6835_NLC_MAX_HARMONICS] = { 0 };
+
+    acumulado = 0;
+    anterior = (raw[0] >> 3) & 0x1FFFFF;
+
+    for (uint32_t i = 0; i < cantidad; i++) {
+        uint32_t angulo = (raw[i] >> 3) & 0x1FFFFF;
+
+        acumulado += (int32_t)((angulo - anterior) << 11) >> 11;
+        anterior = angulo;
+
+        double error = acumulado - (origen + pendiente * i);
+        double theta = angulo * (2.0 * M_PI / (1 << 21));
+
+        for (int k = 0; k < armonicos; k++) {
+            a[k] += error * cos((k + 1) * theta);
+            b[k] += error * sin((k + 1) * theta);
+        }
+    }
+
+    // 4) Cada punto de la tabla guarda la correccion (menos el error) en cuentas de 21 bits
+    for (int j = 0; j < MT6835_NLC_POINTS; j++) {
+        double theta = j * (2.0 * M_PI / MT6835_NLC_POINTS);
+        double error = 0;
+
+        for (int k = 0; k < armonicos; k++) {
+            error += (2.0 / cantidad) * (a[k] * cos((k + 1) * theta) + b[k] * sin((k + 1) * theta));
+        }
+
+        int32_t correccion = -(int32_t)lround(error);
+
+        // 24 bits con signo, big endian
+        tabla[3*j] = (correccion >> 16) & 0xFF;
+        tabla[3*j + 1] = (correccion >> 8) & 0xFF;
+        tabla[3*j + 2] = correccion & 0xFF;
+    }
+
+    return ESP_OK;
+#endif
+}
+
+esp_err_t mt6835_snapshot_read(spi_device_handle_t *mt6835Handle, mt6835_snapshot_t *snapshot, uint8_t conNlc) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_SNAPSHOT_READ);
+
+    esp_err_t error;
+    uint8_t rx[NLC_END - USER_ID + 1];
+    uint32_t cantidad = (conNlc > 0) ? NLC_END - USER_ID + 1 : MT6835_CONF_SIZE;
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // USER_ID..BW y opcionalmente hasta el final de la tabla NLC en una sola transaccion burst
+    error = mt6835_read_block(mt6835Handle, dev, USER_ID, rx, cantidad);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer snapshot: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    for (int i = 0; i < MT6835_CONF_SIZE; i++) {
+        snapshot->regs[i] = rx[i];
+        dev->regs[i] = rx[i];
+    }
+
+    // Aprovecho la lectura para dejar la cache valida
+    dev->valid = MT6835_CACHE_MASK;
+
+    if (conNlc > 0) {
+        for (int i = 0; i < MT6835_NLC_SIZE; i++) {
+            snapshot->nlc[i] = rx[NLC_START - USER_ID + i];
+        }
+    }
+
+    snapshot->conNlc = conNlc > 0;
+
+    return ESP_OK;
+}
+
+uint32_t mt6835_snapshot_compare(const mt6835_snapshot_t *a, const mt6835_snapshot_t *b) {
+    uint32_t diferencias = 0;
+
+    for (uint16_t addr = USER_ID; addr <= BW; addr++) {
+        if ((MT6835_CACHE_MASK & (1 << (addr - USER_ID))) && a->regs[addr - USER_ID] != b->regs[addr - USER_ID]) {
+            diferencias++;
+        }
+    }
+
+    // La tabla NLC se compara solo si esta en las dos imagenes
+    if (a->conNlc && b->conNlc) {
+        for (int i = 0; i < MT6835_NLC_SIZE; i++) {
+            diferencias += a->nlc[i] != b->nlc[i];
+        }
+    }
+
+    return diferencias;
+}
+
+// Escribe los bytes de snapshot distintos de actual, con la cache valida mt6835_write_reg omite los iguales
+static esp_err_t mt6835_snapshot_write(spi_device_handle_t *mt6835Handle, mt6835_dev_t *dev, const mt6835_snapshot_t *actual, const mt6835_snapshot_t *snapshot) {
+    esp_err_t error;
+
+    // La tabla va antes que PWM_CONF para no habilitar NLC con la tabla vieja
+    if (snapshot->conNlc) {
+        error = mt6835_nlc_write_diff(mt6835Handle, dev, actual->nlc, snapshot->nlc);
+
+        if (error != ESP_OK) {
+            return error;
+        }
+    }
+
+    for (uint16_t addr = USER_ID; addr <= BW; addr++) {
+        if (!(MT6835_CACHE_MASK & (1 << (addr - USER_ID)))) {
+            continue;
+        }
+
+        error = mt6835_write_reg(mt6835Handle, dev, addr, snapshot->regs[addr - USER_ID]);
+
+        if (error != ESP_OK) {
+            ESP_LOGE(tag, "Error al escribir registro 0x%03X: %s", addr, esp_err_to_name(error));
+            return error;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_snapshot_restore(spi_device_handle_t *mt6835Handle, const mt6835_snapshot_t *snapshot) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_SNAPSHOT_RESTORE);
+
+    esp_err_t error;
+    mt6835_snapshot_t actual;
+
+    // Leo el estado actual en una transaccion, deja la cache valida
+    error = mt6835_snapshot_read(mt6835Handle, &actual, snapshot->conNlc);
+
+    if (error != ESP_OK) {
+        return error;
+    }
+
+    return mt6835_snapshot_write(mt6835Handle, dev, &actual, snapshot);
+}
+
+esp_err_t mt6835_eeprom_start(spi_device_handle_t *mt6835Handle, const mt6835_snapshot_t *imagen) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_EEPROM_START);
+
+    esp_err_t error;
+    mt6835_snapshot_t actual;
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (dev->eepromOcupada) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    error = mt6835_snapshot_read(mt6835Handle, &actual, (imagen != NULL) ? imagen->conNlc : 1);
+
+    if (error != ESP_OK) {
+        return error;
+    }
+
+    if (imagen == NULL) {
+        imagen = &actual;
+    }
+
+    // Sin escrituras desde el arranque o la ultima grabacion los registros son la EEPROM: si coinciden no grabo
+    if (!dev->sinGrabar && mt6835_snapshot_compare(&actual, imagen) == 0) {
+        MT6835_TRACE(MT6835_EVT_EEPROM_SKIP, 0x000, 0);
+        MT6835_PRINTF("EEPROM sin cambios, no se graba\n");
+        dev->eepromResultado = ESP_OK;
+        return ESP_OK;
+    }
+
+    error = mt6835_snapshot_write(mt6835Handle, dev, &actual, imagen);
+
+    if (error != ESP_OK) {
+        return error;
+    }
+
+    spi_transaction_t operacion = {
+        .cmd = PROG_EEPROM,
+        .addr = 0x000,
+        .length = 24,
+        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
+    };
+
+    error = mt6835_transmit(mt6835Handle, dev, &operacion);
+
+    if (error != ESP_OK || operacion.rx_data[0] != 0x55) {
+        ESP_LOGE(tag, "Error al grabar EEPROM: %s", esp_err_to_name(error));
+        ESP_LOGE(tag, "ACK: 0x%02X != 0x55", operacion.rx_data[0]);
+        dev->eepromResultado = (error != ESP_OK) ? error : ESP_ERR_INVALID_RESPONSE;
+        return dev->eepromResultado;
+    }
+
+    MT6835_TRACE(MT6835_EVT_PROG_EEPROM, 0x000, operacion.rx_data[0]);
+
+    dev->eepromImagen = *imagen;
+    dev->eepromFin = esp_timer_get_time() + MT6835_EEPROM_TIME_US;
+    dev->eepromOcupada = 1;
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_eeprom_poll(spi_device_handle_t *mt6835Handle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_EEPROM_POLL);
+
+    esp_err_t error;
+    mt6835_snapshot_t leida;
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!dev->eepromOcupada) {
+        return dev->eepromResultado;
+    }
+
+    if (esp_timer_get_time() < dev->eepromFin) {
+        return ESP_ERR_NOT_FINISHED;
+    }
+
+    dev->eepromOcupada = 0;
+
+    // Verifico releyendo: los registros tienen que seguir siendo la imagen grabada. Son los registros
+    // volatiles, el contenido de la EEPROM solo se ve despues de un reinicio del MT6835
+    error = mt6835_snapshot_read(mt6835Handle, &leida, dev->eepromImagen.conNlc);
+
+    if (error == ESP_OK && mt6835_snapshot_compare(&leida, &dev->eepromImagen) != 0) {
+        error = ESP_ERR_INVALID_RESPONSE;
+    }
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al verificar EEPROM: %s", esp_err_to_name(error));
+    } else {
+        MT6835_TRACE(MT6835_EVT_EEPROM_OK, 0x000, dev->eepromImagen.conNlc);
+        MT6835_PRINTF("EEPROM grabada correctamente\n");
+        dev->sinGrabar = 0;
+    }
+
+    dev->eepromResultado = error;
+
+    return error;
+}
+
+esp_err_t mt6835_eeprom_complete(spi_device_handle_t *mt6835Handle) {
+    esp_err_t error;
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Solo bloquea la tarea que llama, el resto de los dispositivos sigue disponible
+    while ((error = mt6835_eeprom_poll(mt6835Handle)) == ESP_ERR_NOT_FINISHED) {
+        int64_t restante = dev->eepromFin - esp_timer_get_time();
+        vTaskDelay(pdMS_TO_TICKS(restante / 1000) + 1);
+    }
+
+    return error;
+}
+
+esp_err_t mt6835_latest_publish(spi_device_handle_t *mt6835Handle, uint32_t raw, int64_t timestamp) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_LATEST_PUBLISH);
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t seq = mt6835_seqlock_write_begin(&dev->pubSeq);
+    dev->pub.timestamp = timestamp;
+    dev->pub.raw = raw;
+    dev->pub.seq = seq / 2 + 1;
+    dev->pub.status = raw & 0x07;
+    mt6835_seqlock_write_end(&dev->pubSeq);
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_latest_acquire(spi_device_handle_t *mt6835Handle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_LATEST_ACQUIRE);
+
+    esp_err_t error;
+    uint32_t raw;
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Con CRC invalido no se publica, los lectores ven la muestra anterior como repetida
+    error = mt6835_get_angle_burst(mt6835Handle, &raw);
+
+    if (error != ESP_OK) {
+        return error;
+    }
+
+    // Fin de la transaccion que registro la lectura burst, no el momento de publicar
+    return mt6835_latest_publish(mt6835Handle, raw, dev->timing.fin);
+}
+
+esp_err_t mt6835_latest_read(spi_device_handle_t *mt6835Handle, mt6835_subscriber_t *sub, mt6835_latest_t *muestra) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+
+    if (dev == NULL || atomic_load_explicit(&dev->pubSeq, memory_order_acquire) == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Reintento si el escritor publico en el medio de la copia, con un limite por si quedo desalojado
+    if (!mt6835_seqlock_read(&dev->pubSeq, muestra, &dev->pub, sizeof(*muestra))) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    if (sub != NULL) {
+        uint32_t nuevas = muestra->seq - sub->seq;
+
+        if (nuevas == 0) {
+            sub->repetidas++;
+            return ESP_ERR_NOT_FINISHED;
+        }
+
+        sub->saltadas += nuevas - 1;
+        sub->seq = muestra->seq;
+    }
+
+    return ESP_OK;
+}
+
+void mt6835_tune_init(mt6835_tune_t *tune) {
+    *tune = (mt6835_tune_t) { 0 };
+}
+
+// Descarta muestras hasta que el filtro se asiente despues de cambiar BW
+static esp_err_t mt6835_tune_settle(spi_device_handle_t *mt6835Handle, uint16_t muestras) {
+    esp_err_t error;
+    uint32_t raw;
+
+    for (uint16_t i = 0; i < muestras; i++) {
+        error = mt6835_get_angle_burst(mt6835Handle, &raw);
+
+        if (error != ESP_OK) {
+            return error;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_tune_noise(spi_device_handle_t *mt6835Handle, uint16_t muestras, mt6835_tune_t *tune) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_TUNE_NOISE);
+
+    esp_err_t error;
+    uint8_t bwOriginal;
+    uint32_t raw;
+
+    if (muestras < 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    error = mt6835_get_bw(mt6835Handle, &bwOriginal);
+
+    if (error != ESP_OK) {
+        return error;
+    }
+
+    for (uint8_t bw = 0; bw < 8 && error == ESP_OK; bw++) {
+        error = mt6835_set_bw(mt6835Handle, bw);
+
+        if (error == ESP_OK) {
+            error = mt6835_tune_settle(mt6835Handle, muestras);
+        }
+
+        // Desvio respecto de la primera muestra para no cruzar el salto de vuelta
+        uint32_t primera = 0;
+        int64_t suma = 0, sumaCuadrados = 0;
+
+        for (uint16_t i = 0; i < muestras && error == ESP_OK; i++) {
+            error = mt6835_get_angle_burst(mt6835Handle, &raw);
+
+            if (error != ESP_OK) {
+                break;
+            }
+
+            if (i == 0) {
+                primera = mt6835_raw_to_angle21(raw);
+            }
+
+            int64_t desvio = mt6835_angle21_diff(mt6835_raw_to_angle21(raw), primera);
+            suma += desvio;
+            sumaCuadrados += desvio * desvio;
+        }
+
+        if (error == ESP_OK) {
+            double media = (double)suma / muestras;
+            double varianza = (double)sumaCuadrados / muestras - media * media;
+
+            tune->ruido[bw] = sqrt(varianza > 0.0 ? varianza : 0.0);
+            tune->medidoRuido |= 1 << bw;
+        }
+    }
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error en barrido de ruido: %s", esp_err_to_name(error));
+    }
+
+    // Dejo BW como estaba aunque el barrido haya fallado
+    esp_err_t restaurar = mt6835_set_bw(mt6835Handle, bwOriginal);
+
+    return (error != ESP_OK) ? error : restaurar;
+}
+
+esp_err_t mt6835_tune_lag(spi_device_handle_t *mt6835Handle, uint16_t muestras, mt6835_reference_cb_t ref, void *arg, mt6835_tune_t *tune) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_TUNE_LAG);
+
+    esp_err_t error;
+    uint8_t bwOriginal;
+    uint32_t raw;
+
+    if (muestras < 2 || ref == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    error = mt6835_get_bw(mt6835Handle, &bwOriginal);
+
+    if (error != ESP_OK) {
+        return error;
+    }
+
+    for (uint8_t bw = 0; bw < 8 && error == ESP_OK; bw++) {
+        error = mt6835_set_bw(mt6835Handle, bw);
+
+        if (error == ESP_OK) {
+            error = mt6835_tune_settle(mt6835Handle, muestras);
+        }
+
+        uint32_t anterior = 0;
+        int64_t recorrido = 0, sumaRetardo = 0;
+        int64_t inicio = 0, fin = 0;
+
+        for (uint16_t i = 0; i < muestras && error == ESP_OK; i++) {
+            error = mt6835_get_angle_burst(mt6835Handle, &raw);
+
+            if (error != ESP_OK) {
+                break;
+            }
+
+            uint32_t referencia = ref(arg);
+            int64_t ahora = esp_timer_get_time();
+            uint32_t angulo = mt6835_raw_to_angle21(raw);
+
+            sumaRetardo += mt6835_angle21_diff(referencia & MT6835_ANGLE21_MASK, angulo);
+
+            if (i == 0) {
+                inicio = ahora;
+            } else {
+                recorrido += mt6835_angle21_diff(angulo, anterior);
+            }
+
+            anterior = angulo;
+            fin = ahora;
+        }
+
+        if (error == ESP_OK) {
+            // Retardo a velocidad constante = diferencia de angulo / velocidad
+            double velocidad = (fin > inicio) ? (double)recorrido / (fin - inicio) : 0.0;
+
+            tune->retardoCuentas[bw] = (double)sumaRetardo / muestras;
+            tune->retardoUs[bw] = (velocidad != 0.0) ? tune->retardoCuentas[bw] / velocidad : 0.0;
+            tune->medidoRetardo |= 1 << bw;
+        }
+    }
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error en barrido de retardo: %s", esp_err_to_name(error));
+    }
+
+    esp_err_t restaurar = mt6835_set_bw(mt6835Handle, bwOriginal);
+
+    return (error != ESP_OK) ? error : restaurar;
+}
+
+esp_err_t mt6835_tune_select(spi_device_handle_t *mt6835Handle, const mt6835_tune_t *tune, float maxRetardoUs, uint8_t *bw) {
+    int8_t elegido = -1;
+
+    for (uint8_t i = 0; i < 8; i++) {
+        if (!(tune->medidoRuido & tune->medidoRetardo & (1 << i)) || fabsf(tune->retardoUs[i]) > maxRetardoUs) {
+            continue;
+        }
+
+        if (elegido < 0 || tune->ruido[i] < tune->ruido[elegido]) {
+            elegido = i;
+        }
+    }
+
+    if (elegido < 0) {
+        ESP_LOGW(tag, "Ningun BW cumple el retardo maximo de %.1f us", maxRetardoUs);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (bw != NULL) {
+        *bw = elegido;
+    }
+
+    return mt6835_set_bw(mt6835Handle, elegido);
+}
+
+esp_err_t mt6835_get_timing(spi_device_handle_t *mt6835Handle, mt6835_timing_t *timing) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *timing = dev->timing;
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_predict_angle(spi_device_handle_t *mt6835Handle, const mt6835_observer_t *obs, int64_t objetivo, uint32_t *angle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+
+    if (dev == NULL || dev->timing.inicio == 0 || !obs->init) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // El angulo corresponde al inicio de la transaccion, no al momento en que llego el dato
+    int64_t dt = objetivo - dev->timing.inicio;
+
+    if (dt > 1000000 || dt < -1000000) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *angle = mt6835_observer_predict(obs, (int32_t)dt);
+
+    return ESP_OK;
+}
+
+// Encola una lectura burst en el descriptor libre del doble buffer
+static esp_err_t mt6835_async_queue(spi_device_handle_t *mt6835Handle, mt6835_dev_t *dev) {
+    esp_err_t error;
+    spi_transaction_t *operacion = &dev->asyncOps[dev->asyncSiguiente];
+
+    if (dev->asyncEnCola >= 2) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *operacion = (spi_transaction_t) {
+        .cmd = BURST_READ,
+        .addr = ANGLE_HIGH,
+        .length = 32,
+        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA
+    };
+
+    error = transporte->queue_trans(*mt6835Handle, operacion, 0);
+
+    if (error != ESP_OK) {
+        return error;
+    }
+
+    mt6835_count(dev, operacion);
+    dev->asyncEnCola++;
+    dev->asyncSiguiente ^= 1;
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_read_start(spi_device_handle_t *mt6835Handle, mt6835_read_cb_t cb, void *arg) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_READ_START);
+
+    esp_err_t error;
+
+    // Con pipeline collect ya mantiene una lectura en vuelo, un segundo start la duplicaria
+    if (dev == NULL || (dev->asyncPipeline && dev->asyncEnCola > 0)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    dev->asyncCb = cb;
+    dev->asyncArg = arg;
+
+    error = mt6835_async_queue(mt6835Handle, dev);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al encolar lectura asincronica: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_read_collect(spi_device_handle_t *mt6835Handle, uint32_t *angle, TickType_t espera) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_READ_COLLECT);
+
+    esp_err_t error;
+    spi_transaction_t *operacion;
+
+    if (dev == NULL || dev->asyncEnCola == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    error = transporte->get_trans_result(*mt6835Handle, &operacion, espera);
+
+    if (error != ESP_OK) {
+        // ESP_ERR_TIMEOUT: la lectura todavia no termino
+        return error;
+    }
+
+    dev->asyncEnCola--;
+
+    // Copio la respuesta antes de reencolar: el proximo encolado puede reusar este mismo descriptor
+    uint32_t temp = ((uint32_t)operacion->rx_data[0] << 16) | ((uint32_t)operacion->rx_data[1] << 8) | operacion->rx_data[2];
+    uint32_t crcFail = calculate_crc_raw(temp) != operacion->rx_data[3];
+
+    // La siguiente lectura sale por el bus mientras decodifico esta
+    if (dev->asyncPipeline) {
+        error = mt6835_async_queue(mt6835Handle, dev);
+
+        if (error != ESP_OK) {
+            ESP_LOGE(tag, "Error al encolar lectura asincronica: %s", esp_err_to_name(error));
+        }
+    }
+
+    mt6835_fault_update(dev, temp, crcFail);
+
+    if (crcFail) {
+        error = ESP_ERR_INVALID_CRC;
+    } else {
+        temp = mt6835_correct(dev, temp);
+        error = ESP_OK;
+    }
+
+    if (angle != NULL && error == ESP_OK) {
+        *angle = temp;
+    }
+
+    if (dev->asyncCb != NULL) {
+        dev->asyncCb(dev->asyncArg, error, temp);
+    }
+
+    return error;
+}
+
+esp_err_t mt6835_read_pipeline(spi_device_handle_t *mt6835Handle, uint8_t activo) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    dev->asyncPipeline = activo;
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_stream_start(spi_device_handle_t *mt6835Handle, mt6835_stream_t *stream) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_STREAM_START);
+
+    esp_err_t error;
+
+    stream->handle = mt6835Handle;
+    stream->enCola = 0;
+    stream->activo = 1;
+    mt6835_ring_init(&stream->ring);
+
+    // Encolo todas las lecturas burst de una vez, el driver las encadena sin esperar a la tarea
+    for (int i = 0; i < MT6835_STREAM_DEPTH; i++) {
+        stream->operaciones[i] = (spi_transaction_t) {
+            .cmd = BURST_READ,
+            .addr = ANGLE_HIGH,
+            .length = 32,
+            .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA,
+            .user = &stream->stamps[i]
+        };
+        stream->stamps[i] = (mt6835_stamp_t) { 0 };
+
+        error = transporte->queue_trans(*mt6835Handle, &stream->operaciones[i], portMAX_DELAY);
+
+        if (error != ESP_OK) {
+            ESP_LOGE(tag, "Error al encolar lectura de angulo: %s", esp_err_to_name(error));
+            mt6835_stream_stop(stream);
+            return error;
+        }
+
+        mt6835_count(dev, &stream->operaciones[i]);
+        stream->enCola++;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_stream_service(mt6835_stream_t *stream, TickType_t espera) {
+    mt6835_dev_t *dev = mt6835_dev(stream->handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_STREAM_SERVICE);
+
+    esp_err_t error;
+    spi_transaction_t *operacion;
+    mt6835_sample_t muestra;
+
+    // Retiro como maximo una vuelta de transacciones completas; solo la primera espera
+    for (int i = 0; i < MT6835_STREAM_DEPTH && stream->enCola > 0; i++) {
+        error = transporte->get_trans_result(*stream->handle, &operacion, espera);
+
+        if (error == ESP_ERR_TIMEOUT) {
+            return ESP_OK;
+        }
+
+        if (error != ESP_OK) {
+            ESP_LOGE(tag, "Error al obtener lectura de angulo: %s", esp_err_to_name(error));
+            return error;
+        }
+
+        mt6835_stamp_t *stamp = operacion->user;
+
+        // Con mt6835_spi_post_cb instalado es el fin de la transaccion, si no el momento en que se retira
+        muestra.timestamp = (stamp->fin != 0) ? stamp->fin : esp_timer_get_time();
+        stream->enCola--;
+        espera = 0;
+
+        muestra.raw = ((uint32_t)operacion->rx_data[0] << 16) | ((uint32_t)operacion->rx_data[1] << 8) | operacion->rx_data[2];
+        muestra.crc = operacion->rx_data[3];
+
+        // Vuelvo a encolar antes de procesar para que el bus no quede libre
+        if (stream->activo) {
+            *stamp = (mt6835_stamp_t) { 0 };
+            error = transporte->queue_trans(*stream->handle, operacion, 0);
+
+            if (error != ESP_OK) {
+                ESP_LOGE(tag, "Error al reencolar lectura de angulo: %s", esp_err_to_name(error));
+                return error;
+            }
+
+            mt6835_count(dev, operacion);
+            stream->enCola++;
+        }
+
+        muestra.crcOk = calculate_crc_raw(muestra.raw) == muestra.crc;
+
+        if (dev != NULL) {
+            mt6835_fault_update(dev, muestra.raw, !muestra.crcOk);
+
+            // Mismas correcciones por software que mt6835_get_angle, solo sobre lecturas validas
+            if (muestra.crcOk) {
+                muestra.raw = mt6835_correct(dev, muestra.raw);
+            }
+        }
+
+        mt6835_ring_push(&stream->ring, &muestra);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_stream_stop(mt6835_stream_t *stream) {
+    esp_err_t error;
+    spi_transaction_t *operacion;
+
+    stream->activo = 0;
+
+    // Espero las transacciones pendientes para que el driver no quede con punteros a stream
+    while (stream->enCola > 0) {
+        error = transporte->get_trans_result(*stream->handle, &operacion, portMAX_DELAY);
+
+        if (error != ESP_OK) {
+            ESP_LOGE(tag, "Error al detener streaming: %s", esp_err_to_name(error));
+            return error;
+        }
+
+        stream->enCola--;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_set_lut(spi_device_handle_t *mt6835Handle, const mt6835_lut_t *lut) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // La tabla no se copia, debe seguir existiendo mientras este activa
+    dev->lut = lut;
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_set_zero_offset(spi_device_handle_t *mt6835Handle, mt6835_angle21_t offset) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    dev->zeroOffset = offset & MT6835_ANGLE21_MASK;
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_set_zero_fine(spi_device_handle_t *mt6835Handle, mt6835_angle21_t angle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_SET_ZERO_FINE);
+
+    esp_err_t error;
+    uint8_t zeroLow = 0;
+    uint16_t grueso = (angle & MT6835_ANGLE21_MASK) >> 9;
+
+    // Sin slot no hay donde guardar el cero por software: fallo antes de tocar ZERO_POS
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Los 12 bits altos van a ZERO_POS del MT6835 y los 9 bajos quedan como cero por software
+    error = mt6835_read_reg(mt6835Handle, dev, ZERO_LOW, &zeroLow);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al leer ZERO_LOW: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    error = mt6835_write_reg(mt6835Handle, dev, ZERO_HIGH, grueso >> 4);
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al escribir ZERO_HIGH: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    error = mt6835_write_reg(mt6835Handle, dev, ZERO_LOW, ((grueso << 4) & 0xF0) | (zeroLow & 0x0F));
+
+    if (error != ESP_OK) {
+        ESP_LOGE(tag, "Error al escribir ZERO_LOW: %s", esp_err_to_name(error));
+        return error;
+    }
+
+    MT6835_TRACE(MT6835_EVT_SET_ZERO, ZERO_HIGH, angle);
+
+    dev->zeroOffset = angle & 0x1FF;
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_get_foc(spi_device_handle_t *mt6835Handle, const mt6835_foc_t *foc, mt6835_foc_sample_t *muestra) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+    MT6835_STATS_SCOPE(dev, MT6835_API_GET_FOC);
+
+    esp_err_t error;
+    uint32_t raw = 0;
+
+    // Si la tarea tiene el bus tomado uso la ruta rapida
+    if (dev != NULL && dev->busTomado) {
+        error = mt6835_fast_get_angle(mt6835Handle, &raw);
+    } else {
+        error = mt6835_get_angle_burst(mt6835Handle, &raw);
+    }
+
+    if (error != ESP_OK) {
+        return error;
+    }
+
+    mt6835_foc_compute(foc, raw, muestra);
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_get_faults(spi_device_handle_t *mt6835Handle, mt6835_faults_t *faults) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Copia con las ventanas avanzadas hasta ahora, sin tocar el estado de la ruta caliente
+    *faults = dev->faults;
+    mt6835_fault_advance(faults, esp_timer_get_time());
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_reset_faults(spi_device_handle_t *mt6835Handle) {
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    dev->faults = (mt6835_faults_t) { 0 };
+    dev->faults.window = (uint32_t)(esp_timer_get_time() >> MT6835_FAULT_WINDOW_SHIFT);
+
+    return ESP_OK;
+}
+
+esp_err_t mt6835_stats_get(spi_device_handle_t *mt6835Handle, mt6835_api_stats_t *stats) {
+#if MT6835_STATS
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // stats debe tener MT6835_API_COUNT elementos, indexados por MT6835_API_t
+    for (int i = 0; i < MT6835_API_COUNT; i++) {
+        stats[i] = dev->stats[i];
+    }
+
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t mt6835_stats_reset(spi_device_handle_t *mt6835Handle) {
+#if MT6835_STATS
+    mt6835_dev_t *dev = mt6835_dev(mt6835Handle);
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    for (int i = 0; i < MT6835_API_COUNT; i++) {
+        dev->stats[i] = (mt6835_api_stats_t) { 0 };
+    }
+
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+uint32_t mt6835_trace_read(mt6835_trace_t *eventos, uint32_t max) {
+#if MT6835_LOG_MODE == MT6835_LOG_TRACE
+    uint32_t head = atomic_load_explicit(&traceHead, memory_order_relaxed);
+    uint32_t cantidad = (head < MT6835_TRACE_SIZE) ? head : MT6835_TRACE_SIZE;
+
+    cantidad = (cantidad < max) ? cantidad : max;
+
+    // Del mas viejo al mas nuevo
+    for (uint32_t i = 0; i < cantidad; i++) {
+        eventos[i] = traceBuf[(head - cantidad + i) & (MT6835_TRACE_SIZE - 1)];
+    }
+
+    return cantidad;
+#else
+    return 0;
+#endif
+}
+
+void mt6835_trace_dump(void) {
+#if MT6835_LOG_MODE == MT6835_LOG_TRACE
+    static const char *nombres[] = {
+        "GET_USER_ID", "SET_USER_ID", "GET_ABZ_RES", "SET_ABZ_RES", "GET_ABZ_OFF", "SET_ABZ_OFF",
+        "GET_ABZ_SWAP", "SET_ABZ_SWAP", "SET_CUR_ZERO", "SET_ZERO", "GET_Z_EDGE", "SET_Z_EDGE",
+        "GET_Z_WIDTH", "SET_Z_WIDTH", "GET_Z_PHASE", "SET_Z_PHASE", "GET_ABZ_LEAD", "SET_ABZ_LEAD",
+        "PROG_EEPROM", "GET_BW", "SET_BW", "GET_HYST", "SET_HYST", "EEPROM_SKIP", "EEPROM_OK"
+    };
+    _Static_assert(sizeof nombres / sizeof nombres[0] == MT6835_EVT_COUNT, "Falta el nombre de algun MT6835_EVT_t");
+    mt6835_trace_t evento;
+    uint32_t head = atomic_load_explicit(&traceHead, memory_order_relaxed);
+    uint32_t cantidad = (head < MT6835_TRACE_SIZE) ? head : MT6835_TRACE_SIZE;
+
+    for (uint32_t i = 0; i < cantidad; i++) {
+        evento = traceBuf[(head - cantidad + i) & (MT6835_TRACE_SIZE - 1)];
+        printf("%10lu %-13s 0x%03X %lu\n", (unsigned long)evento.timestamp,
+               (evento.event < MT6835_EVT_COUNT) ? nombres[evento.event] : "?", evento.reg, (unsigned long)evento.value);
+    }
+#endif
+}
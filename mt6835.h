@@ -1,7 +1,14 @@
+#ifndef MT6835_H
+#define MT6835_H
+
 #include <stdint.h>
+#include "freertos/FreeRTOS.h"
 #include "driver/spi_master.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "mt6835_ring.h"
+#include "mt6835_angle.h"
+#include "mt6835_track.h"
 
 typedef enum MT6835_CMD_t {
     READ        = 0b0011,
@@ -30,15 +37,330 @@ typedef enum MT6835_ADDR_t {
     NLC_END      = 0x0D2
 };
 
+// Funciones de bus que usa el driver, por defecto las del driver SPI de ESP-IDF
+// Se reemplazan para correr el driver contra un modelo del MT6835 (ver mt6835_sim.h)
+typedef struct {
+    esp_err_t (*transmit)(spi_device_handle_t handle, spi_transaction_t *trans);
+    esp_err_t (*polling_transmit)(spi_device_handle_t handle, spi_transaction_t *trans);
+    esp_err_t (*queue_trans)(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t espera);
+    esp_err_t (*get_trans_result)(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t espera);
+    esp_err_t (*acquire_bus)(spi_device_handle_t handle, TickType_t espera);
+    void (*release_bus)(spi_device_handle_t handle);
+} mt6835_transport_t;
+
+// Modo de log de las rutas exitosas, elegido en tiempo de compilacion
+// Los errores siempre van por ESP_LOGE
+#define MT6835_LOG_NONE     0   // Nada
+#define MT6835_LOG_TRACE    1   // Eventos binarios en un buffer circular, ver mt6835_trace_dump
+#define MT6835_LOG_PRINTF   2   // Texto por consola como antes
+
+#ifndef MT6835_LOG_MODE
+#define MT6835_LOG_MODE MT6835_LOG_TRACE
+#endif
+
+#ifndef MT6835_TRACE_SIZE
+#define MT6835_TRACE_SIZE 64    // Eventos guardados, debe ser potencia de 2
+#endif
+
+typedef enum {
+    MT6835_EVT_GET_USER_ID,
+    MT6835_EVT_SET_USER_ID,
+    MT6835_EVT_GET_ABZ_RES,
+    MT6835_EVT_SET_ABZ_RES,
+    MT6835_EVT_GET_ABZ_OFF,
+    MT6835_EVT_SET_ABZ_OFF,
+    MT6835_EVT_GET_ABZ_SWAP,
+    MT6835_EVT_SET_ABZ_SWAP,
+    MT6835_EVT_SET_CUR_ZERO,
+    MT6835_EVT_SET_ZERO,
+    MT6835_EVT_GET_Z_EDGE,
+    MT6835_EVT_SET_Z_EDGE,
+    MT6835_EVT_GET_Z_WIDTH,
+    MT6835_EVT_SET_Z_WIDTH,
+    MT6835_EVT_GET_Z_PHASE,
+    MT6835_EVT_SET_Z_PHASE,
+    MT6835_EVT_GET_ABZ_LEAD,
+    MT6835_EVT_SET_ABZ_LEAD,
+    MT6835_EVT_PROG_EEPROM,
+    MT6835_EVT_GET_BW,
+    MT6835_EVT_SET_BW,
+    MT6835_EVT_GET_HYST,
+    MT6835_EVT_SET_HYST,
+    MT6835_EVT_EEPROM_SKIP,     // eeprom_start sin cambios, no se manda PROG_EEPROM
+    MT6835_EVT_EEPROM_OK,       // eeprom_poll verifico la grabacion
+    MT6835_EVT_COUNT
+} MT6835_EVT_t;
+
+typedef struct {
+    uint32_t timestamp;         // Ciclos de CPU
+    uint32_t value;             // Valor leido o escrito
+    uint16_t reg;               // Direccion del registro
+    uint8_t event;              // MT6835_EVT_t
+} mt6835_trace_t;
+
+// Instrumentacion por dispositivo y por funcion publica, desactivada por defecto
+// Con MT6835_STATS 0 no queda ningun rastro en la ruta de lectura
+#ifndef MT6835_STATS
+#define MT6835_STATS 0
+#endif
+
+#ifndef MT6835_STATS_BUCKETS
+#define MT6835_STATS_BUCKETS 12     // Buckets logaritmicos de latencia
+#endif
+
+#ifndef MT6835_STATS_SHIFT
+#define MT6835_STATS_SHIFT 6        // Bucket 0: menos de 2^7 ciclos
+#endif
+
+typedef enum {
+    MT6835_API_GET_USER_ID,
+    MT6835_API_SET_USER_ID,
+    MT6835_API_GET_ANGLE,
+    MT6835_API_GET_ANGLE_BURST,
+    MT6835_API_PROGRAM_EEPROM,
+    MT6835_API_GET_ABZ_RES,
+    MT6835_API_SET_ABZ_RES,
+    MT6835_API_GET_ABZ_OFF,
+    MT6835_API_SET_ABZ_OFF,
+    MT6835_API_GET_ABZ_SWAP,
+    MT6835_API_SET_ABZ_SWAP,
+    MT6835_API_SET_CUR_POSITION_ZERO,
+    MT6835_API_SET_ZERO,
+    MT6835_API_GET_Z_EDGE,
+    MT6835_API_SET_Z_EDGE,
+    MT6835_API_GET_Z_PULSE_WIDTH,
+    MT6835_API_SET_Z_PULSE_WIDTH,
+    MT6835_API_GET_Z_PHASE,
+    MT6835_API_SET_Z_PHASE,
+    MT6835_API_GET_ABZ_LEAD,
+    MT6835_API_SET_ABZ_LEAD,
+    MT6835_API_CACHE_REFRESH,
+    MT6835_API_CONFIG_READ,
+    MT6835_API_CONFIG_APPLY,
+    MT6835_API_FAST_GET_ANGLE,
+    MT6835_API_NLC_READ,
+    MT6835_API_NLC_WRITE,
+    MT6835_API_NLC_ENABLE,
+    MT6835_API_SET_ZERO_FINE,
+    MT6835_API_GET_FOC,
+    MT6835_API_STREAM_SERVICE,
+    MT6835_API_READ_START,
+    MT6835_API_READ_COLLECT,
+    MT6835_API_SNAPSHOT_READ,
+    MT6835_API_SNAPSHOT_RESTORE,
+    MT6835_API_EEPROM_START,
+    MT6835_API_EEPROM_POLL,
+    MT6835_API_LATEST_ACQUIRE,
+    MT6835_API_GET_BW,
+    MT6835_API_SET_BW,
+    MT6835_API_GET_HYST,
+    MT6835_API_SET_HYST,
+    MT6835_API_TUNE_NOISE,
+    MT6835_API_TUNE_LAG,
+    MT6835_API_SCHED_READ,              // Una llamada por pasada en el dispositivo de cada eje
+    MT6835_API_STREAM_START,
+    MT6835_API_LATEST_PUBLISH,
+    MT6835_API_COUNT
+} MT6835_API_t;
+
+typedef struct {
+    uint32_t calls;
+    uint32_t transactions;
+    uint32_t bytes;                         // Bytes en el cable, incluyendo comando y direccion
+    uint32_t errors;                        // Transacciones fallidas y CRC invalidos
+    uint32_t latency[MT6835_STATS_BUCKETS]; // Bucket i: [2^(i+SHIFT), 2^(i+SHIFT+1)) ciclos
+} mt6835_api_stats_t;
+
+#ifndef MT6835_MAX_DEVICES
+#define MT6835_MAX_DEVICES 6    // Dispositivos con cache de registros y contadores propios
+#endif
+
+// Tiempos de una transaccion en us (esp_timer_get_time), los escriben mt6835_spi_pre_cb y mt6835_spi_post_cb
+// Sin los callbacks instalados quedan en 0 y el driver usa el momento en que retira el resultado
+typedef struct {
+    int64_t inicio;             // pre_cb: justo antes de bajar CS
+    int64_t fin;                // post_cb: fin de la transaccion
+} mt6835_stamp_t;
+
+#define MT6835_CONF_SIZE (BW - USER_ID + 1)    // Registros USER_ID..BW guardados en cache
+
+#ifndef MT6835_STREAM_DEPTH
+#define MT6835_STREAM_DEPTH 4   // Transacciones encoladas en simultaneo en modo streaming
+#endif
+
+typedef struct {
+    spi_device_handle_t *handle;
+    spi_transaction_t operaciones[MT6835_STREAM_DEPTH];
+    mt6835_stamp_t stamps[MT6835_STREAM_DEPTH];     // user de cada operacion
+    uint32_t enCola;            // Transacciones encoladas sin resultado retirado
+    uint8_t activo;
+    mt6835_ring_t ring;         // Los consumidores leen con mt6835_ring_pop(&stream->ring, ...)
+} mt6835_stream_t;
+
+// Configuracion completa del MT6835, se aplica con mt6835_config_apply
+typedef struct {
+    uint16_t abzRes;            // ppr, 1 a 16384
+    uint8_t abzOff;
+    uint8_t abzSwap;
+    uint16_t zeroPos;           // Valor crudo de 12 bits de ZERO_POS (LSB = 360° / 4096)
+    uint8_t zEdge;
+    uint8_t zWidth;             // 0 a 7
+    uint8_t zPhase;             // 0 a 3
+    uint8_t rotDir;             // 0: CCW_BA, 1: CCW_AB
+    uint8_t hyst;               // 0 a 7
+    uint8_t bw;                 // 0 a 7
+    uint8_t autocalFreq;        // 0 a 7
+} mt6835_config_t;
+
+#ifndef MT6835_SCHED_MAX_AXES
+#define MT6835_SCHED_MAX_AXES 6     // Encoders por scheduler (mismo host SPI)
+#endif
+
+_Static_assert(MT6835_MAX_DEVICES >= MT6835_SCHED_MAX_AXES, "Cada eje del scheduler necesita un slot de dispositivo");
+
+// Varios MT6835 en un mismo host: una pasada encola una lectura burst por eje y junta los resultados
+typedef struct {
+    spi_device_handle_t *handles[MT6835_SCHED_MAX_AXES];
+    spi_transaction_t operaciones[MT6835_SCHED_MAX_AXES];
+    mt6835_stamp_t stamps[MT6835_SCHED_MAX_AXES];
+    uint32_t ejes;
+} mt6835_sched_t;
+
+// timestamp es el fin de la transaccion (mt6835_stamp_t.fin), no el momento en que el MT6835 congela el
+// angulo: ese es el inicio, una transaccion de 6 bytes antes. Todos los ejes tienen el mismo largo, asi que
+// el skew es el mismo medido con cualquiera de los dos
+typedef struct {
+    uint32_t raw[MT6835_SCHED_MAX_AXES];         // Mismo formato que mt6835_get_angle, sin correcciones si fallo el CRC
+    int64_t timestamp[MT6835_SCHED_MAX_AXES];    // us, fin de la transaccion de cada eje
+    int32_t skew[MT6835_SCHED_MAX_AXES];         // us, respecto del primer eje sin error
+    int32_t maxSkew;                             // us, entre el primer y el ultimo eje sin error
+    uint32_t crcFail;                            // Bit i en 1 = CRC invalido en el eje i
+    uint32_t error;                              // Bit i en 1 = transaccion fallida en el eje i: raw, timestamp y skew en 0
+} mt6835_sched_sample_t;
+
+// Ultima muestra publicada por el dueno de la adquisicion, los lectores la toman sin locks ni bus
+typedef struct {
+    int64_t timestamp;          // us, fin de la transaccion
+    uint32_t raw;               // Mismo formato que mt6835_get_angle, con las correcciones aplicadas
+    uint32_t seq;               // Numero de muestra, empieza en 1
+    uint8_t status;             // Bits MT6835_STATUS_t
+} mt6835_latest_t;
+
+// Estado de cada lector para detectar muestras repetidas o salteadas
+typedef struct {
+    uint32_t seq;               // Ultima muestra leida
+    uint32_t saltadas;          // Muestras publicadas que este lector no vio
+    uint32_t repetidas;         // Lecturas sin muestra nueva
+} mt6835_subscriber_t;
+
+// Angulo de 21 bits de una referencia externa (otro encoder, posicion comandada) en el momento de la llamada
+typedef uint32_t (*mt6835_reference_cb_t)(void *arg);
+
+// Resultado del barrido de BW, indice = valor de BW (0 a 7)
+typedef struct {
+    float ruido[8];             // Cuentas RMS con el motor detenido
+    float retardoCuentas[8];    // Referencia - angulo medido, promedio a velocidad constante
+    float retardoUs[8];         // retardoCuentas / velocidad
+    uint8_t medidoRuido;        // Bit i en 1 = ruido[i] medido
+    uint8_t medidoRetardo;      // Bit i en 1 = retardo[i] medido
+} mt6835_tune_t;
+
+// Tiempos de la ultima adquisicion de angulo (get_angle, get_angle_burst y la ruta rapida con CRC valido)
+// Son exactos con mt6835_spi_pre_cb/post_cb instalados, si no se toman en la tarea y inicio queda
+// unos us antes de bajar CS (ver mt6835_stamp_t)
+typedef struct {
+    int64_t inicio;             // us, inicio de la transaccion: el MT6835 congela el angulo al bajar CS
+    int64_t fin;                // us, fin de la transaccion
+    uint32_t latencia;          // us, fin - inicio de la ultima adquisicion
+    uint32_t latenciaMax;       // us, desde el arranque
+} mt6835_timing_t;
+
+// Callback de lectura asincronica, se llama desde mt6835_read_collect en la tarea que la llama
+typedef void (*mt6835_read_cb_t)(void *arg, esp_err_t error, uint32_t angle);
+
+// Tabla NLC (0x013..0x0D2): MT6835_NLC_POINTS puntos equiespaciados en una vuelta,
+// cada uno una correccion de 24 bits con signo (big endian) en cuentas de 21 bits
+#define MT6835_NLC_SIZE         (NLC_END - NLC_START + 1)
+#define MT6835_NLC_POINTS       64
+#define MT6835_NLC_MAX_HARMONICS 8
+
+// El formato de arriba no esta confirmado contra la hoja de datos: mt6835_nlc_calibrate solo arma tablas
+// con MT6835_NLC_LAYOUT en 1, si no retorna ESP_ERR_NOT_SUPPORTED. Lectura y escritura de bytes no dependen de esto
+#ifndef MT6835_NLC_LAYOUT
+#define MT6835_NLC_LAYOUT 0
+#endif
+
+#ifndef MT6835_NLC_QUEUE
+#define MT6835_NLC_QUEUE 8      // Escrituras NLC encoladas en simultaneo
+#endif
+
+// Requisitos del bus y del dispositivo para usar todo el driver:
+// - mt6835_nlc_read (192 bytes) y mt6835_snapshot_read con NLC (210 bytes) superan los 64 bytes que el
+//   driver SPI acepta sin DMA: inicializar el bus con DMA (ej. SPI_DMA_CH_AUTO) y max_transfer_sz >= MT6835_MAX_TRANSFER
+// - Las escrituras NLC y el modo streaming encolan varias transacciones: queue_size >= MT6835_QUEUE_SIZE
+// Sin NLC ni snapshots con NLC alcanza con el bus sin DMA y queue_size = MT6835_STREAM_DEPTH
+#define MT6835_MAX_TRANSFER     (2 + NLC_END - USER_ID + 1)     // Comando y direccion + USER_ID..NLC_END
+#define MT6835_QUEUE_SIZE       ((MT6835_NLC_QUEUE > MT6835_STREAM_DEPTH) ? MT6835_NLC_QUEUE : MT6835_STREAM_DEPTH)
+
+// Imagen de configuracion para auditar o clonar un MT6835
+// Los registros de angulo (0x003..0x006) y las direcciones sin uso se leen pero no se comparan ni restauran
+typedef struct {
+    uint8_t regs[MT6835_CONF_SIZE];     // USER_ID..BW, indice = direccion - USER_ID
+    uint8_t nlc[MT6835_NLC_SIZE];
+    uint8_t conNlc;                     // nlc es valido
+} mt6835_snapshot_t;
+
+#ifndef MT6835_EEPROM_TIME_US
+#define MT6835_EEPROM_TIME_US 6000000   // Espera despues de PROG_EEPROM
+#endif
+
+// Bits de estado de ANGLE_LOW
+typedef enum MT6835_STATUS_t {
+    MT6835_STATUS_OVERSPEED    = 0x01,
+    MT6835_STATUS_WEAK_FIELD   = 0x02,
+    MT6835_STATUS_UNDERVOLTAGE = 0x04
+} MT6835_STATUS_t;
+
+#ifndef MT6835_FAULT_WINDOWS
+#define MT6835_FAULT_WINDOWS 16         // Ventanas del histograma de fallas
+#endif
+
+#ifndef MT6835_FAULT_WINDOW_SHIFT
+#define MT6835_FAULT_WINDOW_SHIFT 17    // Duracion de cada ventana: 2^17 us = 131 ms
+#endif
+
+// Contadores de fallas por dispositivo, se actualizan en cada lectura de angulo
+typedef struct {
+    uint32_t samples;
+    uint32_t overspeed;
+    uint32_t weakField;
+    uint32_t underVoltage;
+    uint32_t crcFail;                               // Solo de lecturas burst, mt6835_get_angle no verifica CRC
+    uint32_t window;                                // Indice absoluto de la ventana actual
+    uint16_t histogram[MT6835_FAULT_WINDOWS];       // Muestras con falla por ventana, circular
+} mt6835_faults_t;
+
 typedef enum MT6835_ROT_DIR_t {
     CCW_BA = 0b00000000,
     CCW_AB = 0b00001000
 };
 
+void mt6835_set_transport(const mt6835_transport_t *transporte);                    // NULL vuelve al driver de ESP-IDF
+// Para .pre_cb y .post_cb de spi_device_interface_config_t: marcan las transacciones del driver que llevan un
+// mt6835_stamp_t en user (las demas no se tocan). Si el dispositivo ya usa sus propios callbacks, llamarlos desde ahi
+void mt6835_spi_pre_cb(spi_transaction_t *trans);
+void mt6835_spi_post_cb(spi_transaction_t *trans);
+// Registra el handle en la tabla de dispositivos (cache, contadores, fallas, ruta rapida, etc.), llamar una vez
+// despues de spi_bus_add_device y antes de usarlo desde otras tareas. Sin registrar solo funcionan las lecturas
+// y escrituras directas, lo que necesita estado por dispositivo retorna ESP_ERR_INVALID_STATE
+esp_err_t mt6835_attach(spi_device_handle_t *mt6835Handle);                          // ESP_ERR_NO_MEM si la tabla esta llena
 esp_err_t mt6835_get_user_id(spi_device_handle_t *mt6835Handle, uint8_t *userID);
 esp_err_t mt6835_set_user_id(spi_device_handle_t *mt6835Handle, uint8_t userID);
 esp_err_t mt6835_get_angle(spi_device_handle_t *mt6835Handle, uint32_t *angle);
+esp_err_t mt6835_get_angle_burst(spi_device_handle_t *mt6835Handle, uint32_t *angle);    // Angulo + estado + CRC en una transaccion
 uint8_t calculate_crc(uint32_t angle);
+uint8_t calculate_crc_raw(uint32_t raw);                                                // CRC sobre 24 bits (angulo + estado)
+uint32_t mt6835_check_crc_batch(const uint32_t *raw, const uint8_t *crc, uint32_t count, uint32_t *failBitmap);  // Retorna cantidad de fallas
 esp_err_t mt6835_program_eeprom(spi_device_handle_t *mt6835Handle);
 esp_err_t mt6835_get_abz_res(spi_device_handle_t *mt6835Handle, uint16_t *abzRes);
 esp_err_t mt6835_set_abz_res(spi_device_handle_t *mt6835Handle, uint16_t abzRes);
@@ -56,5 +378,83 @@ esp_err_t mt6835_get_z_phase(spi_device_handle_t *mt6835Handle, uint8_t *zPhase)
 esp_err_t mt6835_set_z_phase(spi_device_handle_t *mt6835Handle, uint8_t zPhase);
 esp_err_t mt6835_get_abz_lead(spi_device_handle_t *mt6835Handle, uint8_t *abLead);
 esp_err_t mt6835_set_abz_lead(spi_device_handle_t *mt6835Handle, uint8_t abLead);
+// Cache de registros de configuracion: los getters se sirven de la cache y los setters cuestan una escritura
+// Llamar a invalidate si el MT6835 se reinicia o recarga la EEPROM
+esp_err_t mt6835_cache_invalidate(spi_device_handle_t *mt6835Handle);
+esp_err_t mt6835_cache_refresh(spi_device_handle_t *mt6835Handle);                  // Relee USER_ID..BW en una transaccion
+uint32_t mt6835_get_transaction_count(spi_device_handle_t *mt6835Handle);
+void mt6835_reset_transaction_count(spi_device_handle_t *mt6835Handle);
+esp_err_t mt6835_config_read(spi_device_handle_t *mt6835Handle, mt6835_config_t *config);
+esp_err_t mt6835_config_apply(spi_device_handle_t *mt6835Handle, const mt6835_config_t *config);   // Escribe solo los bytes que cambian
+// Ruta rapida: entre begin y end el bus queda tomado y las lecturas son por polling, sin log
+// Ciclos por lectura contra get_angle y get_angle_burst en examples/fast_path
+esp_err_t mt6835_fast_begin(spi_device_handle_t *mt6835Handle);
+esp_err_t mt6835_fast_get_angle(spi_device_handle_t *mt6835Handle, uint32_t *angle);
+esp_err_t mt6835_fast_end(spi_device_handle_t *mt6835Handle);
+void mt6835_sched_init(mt6835_sched_t *sched);
+esp_err_t mt6835_sched_add(mt6835_sched_t *sched, spi_device_handle_t *mt6835Handle);
+esp_err_t mt6835_sched_read(mt6835_sched_t *sched, mt6835_sched_sample_t *muestra);   // Lee todos los ejes en una pasada, ver muestra->error
+esp_err_t mt6835_nlc_read(spi_device_handle_t *mt6835Handle, uint8_t *tabla);                  // MT6835_NLC_SIZE bytes, una transaccion
+esp_err_t mt6835_nlc_write(spi_device_handle_t *mt6835Handle, const uint8_t *tabla);            // Escribe solo los bytes distintos
+esp_err_t mt6835_nlc_enable(spi_device_handle_t *mt6835Handle, uint8_t nlcEn);
+// Arma la tabla NLC a partir de una captura a velocidad constante que cubra al menos una vuelta (ver MT6835_NLC_LAYOUT)
+esp_err_t mt6835_nlc_calibrate(const uint32_t *raw, uint32_t cantidad, uint8_t armonicos, uint8_t *tabla);
+esp_err_t mt6835_set_lut(spi_device_handle_t *mt6835Handle, const mt6835_lut_t *lut);    // NULL desactiva la correccion
+// Cero a resolucion completa: set_zero_fine reparte entre ZERO_POS (12 bits) y el cero por software (9 bits)
+// Sin mt6835_attach retorna ESP_ERR_INVALID_STATE sin escribir ZERO_POS. set_zero y set_cur_position_zero
+// reemplazan ZERO_POS y borran el cero por software
+esp_err_t mt6835_set_zero_offset(spi_device_handle_t *mt6835Handle, mt6835_angle21_t offset);
+esp_err_t mt6835_set_zero_fine(spi_device_handle_t *mt6835Handle, mt6835_angle21_t angle);
+// Angulo mecanico, electrico y sin/cos Q15 de una sola lectura
+esp_err_t mt6835_get_foc(spi_device_handle_t *mt6835Handle, const mt6835_foc_t *foc, mt6835_foc_sample_t *muestra);
+esp_err_t mt6835_get_faults(spi_device_handle_t *mt6835Handle, mt6835_faults_t *faults);
+esp_err_t mt6835_reset_faults(spi_device_handle_t *mt6835Handle);
+esp_err_t mt6835_stats_get(spi_device_handle_t *mt6835Handle, mt6835_api_stats_t *stats);  // MT6835_API_COUNT elementos
+esp_err_t mt6835_stats_reset(spi_device_handle_t *mt6835Handle);
+// Snapshot: una sola lectura burst (incluye la tabla NLC si conNlc > 0), restore escribe solo los bytes distintos
+esp_err_t mt6835_snapshot_read(spi_device_handle_t *mt6835Handle, mt6835_snapshot_t *snapshot, uint8_t conNlc);
+uint32_t mt6835_snapshot_compare(const mt6835_snapshot_t *a, const mt6835_snapshot_t *b);   // Cantidad de bytes escribibles distintos
+esp_err_t mt6835_snapshot_restore(spi_device_handle_t *mt6835Handle, const mt6835_snapshot_t *snapshot);
+// Grabacion de EEPROM sin bloquear: start escribe imagen (NULL = registros actuales) y manda PROG_EEPROM,
+// poll devuelve ESP_ERR_NOT_FINISHED durante la espera y luego verifica releyendo los registros
+// Si no hubo escrituras desde el arranque o la ultima grabacion y los registros ya son la imagen, no se graba
+// La verificacion relee los registros volatiles, no la EEPROM: para confirmar la grabacion reiniciar el MT6835,
+// llamar a mt6835_cache_invalidate y comparar un snapshot nuevo contra la imagen
+esp_err_t mt6835_eeprom_start(spi_device_handle_t *mt6835Handle, const mt6835_snapshot_t *imagen);
+esp_err_t mt6835_eeprom_poll(spi_device_handle_t *mt6835Handle);
+esp_err_t mt6835_eeprom_complete(spi_device_handle_t *mt6835Handle);    // Bloquea la tarea hasta que poll termine
+// Publicacion de la ultima muestra (seqlock por dispositivo): un solo escritor, lectores en cualquier tarea
+// latest_read devuelve ESP_ERR_NOT_FINISHED si la muestra es la misma que el lector ya vio (sub puede ser NULL)
+// y ESP_ERR_TIMEOUT si el escritor no termino de publicar en MT6835_SEQLOCK_RETRIES intentos
+esp_err_t mt6835_latest_publish(spi_device_handle_t *mt6835Handle, uint32_t raw, int64_t timestamp);
+esp_err_t mt6835_latest_acquire(spi_device_handle_t *mt6835Handle);    // Lectura burst y publicacion
+esp_err_t mt6835_latest_read(spi_device_handle_t *mt6835Handle, mt6835_subscriber_t *sub, mt6835_latest_t *muestra);
+// Filtro interno del MT6835 y histeresis de las salidas incrementales
+esp_err_t mt6835_get_bw(spi_device_handle_t *mt6835Handle, uint8_t *bw);
+esp_err_t mt6835_set_bw(spi_device_handle_t *mt6835Handle, uint8_t bw);
+esp_err_t mt6835_get_hyst(spi_device_handle_t *mt6835Handle, uint8_t *hyst);
+esp_err_t mt6835_set_hyst(spi_device_handle_t *mt6835Handle, uint8_t hyst);
+// Auto ajuste de BW: tune_noise con el motor detenido, tune_lag a velocidad constante, despues tune_select
+// Los barridos dejan BW como estaba, select elige el menor ruido con retardo <= maxRetardoUs y lo escribe
+void mt6835_tune_init(mt6835_tune_t *tune);
+esp_err_t mt6835_tune_noise(spi_device_handle_t *mt6835Handle, uint16_t muestras, mt6835_tune_t *tune);
+esp_err_t mt6835_tune_lag(spi_device_handle_t *mt6835Handle, uint16_t muestras, mt6835_reference_cb_t ref, void *arg, mt6835_tune_t *tune);
+esp_err_t mt6835_tune_select(spi_device_handle_t *mt6835Handle, const mt6835_tune_t *tune, float maxRetardoUs, uint8_t *bw);
+// Compensacion de retardo: angulo de 21 bits predicho para objetivo (us, base de esp_timer_get_time)
+// desde el inicio de la ultima adquisicion, obs tiene que estar actualizado con esa misma muestra
+esp_err_t mt6835_get_timing(spi_device_handle_t *mt6835Handle, mt6835_timing_t *timing);
+esp_err_t mt6835_predict_angle(spi_device_handle_t *mt6835Handle, const mt6835_observer_t *obs, int64_t objetivo, uint32_t *angle);
+// Lectura asincronica: start encola, collect retira el resultado (espera = 0 para consultar sin bloquear)
+// Con pipeline activo collect encola la siguiente lectura antes de decodificar la actual, start solo
+// arranca la cadena (ESP_ERR_INVALID_STATE si ya hay una lectura en vuelo)
+// No mezclar con el modo streaming en el mismo dispositivo
+esp_err_t mt6835_read_start(spi_device_handle_t *mt6835Handle, mt6835_read_cb_t cb, void *arg);
+esp_err_t mt6835_read_collect(spi_device_handle_t *mt6835Handle, uint32_t *angle, TickType_t espera);
+esp_err_t mt6835_read_pipeline(spi_device_handle_t *mt6835Handle, uint8_t activo);
+uint32_t mt6835_trace_read(mt6835_trace_t *eventos, uint32_t max);                 // Copia los ultimos eventos, del mas viejo al mas nuevo
+void mt6835_trace_dump(void);
+esp_err_t mt6835_stream_start(spi_device_handle_t *mt6835Handle, mt6835_stream_t *stream);
+esp_err_t mt6835_stream_service(mt6835_stream_t *stream, TickType_t espera);        // Llamar desde la tarea productora
+esp_err_t mt6835_stream_stop(mt6835_stream_t *stream);
 
-
+#endif
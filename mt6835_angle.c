@@ -0,0 +1,79 @@
+#include "mt6835_angle.h"
+
+// sin(2*pi*i/256) en Q15, con un punto extra para interpolar el ultimo tramo
+static const int16_t senoTabla[257] = {
+    0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739,
+    9512, 10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811,
+    25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521,
+    32609, 32678, 32728, 32757, 32767, 32757, 32728, 32678, 32609, 32521, 32412, 32285,
+    32137, 31971, 31785, 31580, 31356, 31113, 30852, 30571, 30273, 29956, 29621, 29268,
+    28898, 28510, 28105, 27683, 27245, 26790, 26319, 25832, 25329, 24811, 24279, 23731,
+    23170, 22594, 22005, 21403, 20787, 20159, 19519, 18868, 18204, 17530, 16846, 16151,
+    15446, 14732, 14010, 13279, 12539, 11793, 11039, 10278, 9512, 8739, 7962, 7179,
+    6393, 5602, 4808, 4011, 3212, 2410, 1608, 804, 0, -804, -1608, -2410,
+    -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739, -9512, -10278, -11039, -11793,
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530, -18204, -18868, -19519, -20159,
+    -20787, -21403, -22005, -22594, -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790,
+    -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956, -30273, -30571, -30852, -31113,
+    -31356, -31580, -31785, -31971, -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285, -32137, -31971, -31785, -31580,
+    -31356, -31113, -30852, -30571, -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683,
+    -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731, -23170, -22594, -22005, -21403,
+    -20787, -20159, -19519, -18868, -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+    -12539, -11793, -11039, -10278, -9512, -8739, -7962, -7179, -6393, -5602, -4808, -4011,
+    -3212, -2410, -1608, -804, 0
+};
+
+void mt6835_lut_apply_batch(const mt6835_lut_t *lut, uint32_t *raw, uint32_t cantidad) {
+    // Sin saltos dentro del lazo para que el compilador lo pueda vectorizar/desenrollar
+    for (uint32_t i = 0; i < cantidad; i++) {
+        raw[i] = mt6835_lut_apply(lut, raw[i]);
+    }
+}
+
+void mt6835_lut_build(mt6835_lut_t *lut, const int32_t *puntos, uint32_t cantidad) {
+    for (uint32_t j = 0; j < MT6835_LUT_SIZE; j++) {
+        // Posicion del tramo j en unidades de puntos, con 16 bits de fraccion
+        uint64_t pos = ((uint64_t)j * cantidad << 16) / MT6835_LUT_SIZE;
+        uint32_t k = pos >> 16;
+        int64_t frac = pos & 0xFFFF;
+        int64_t p0 = puntos[k % cantidad];
+        int64_t p1 = puntos[(k + 1) % cantidad];
+        int64_t valor = p0 + (((p1 - p0) * frac) >> 16);
+
+        // Saturo a int16
+        lut->corr[j] = (valor > INT16_MAX) ? INT16_MAX : (valor < INT16_MIN) ? INT16_MIN : (int16_t)valor;
+    }
+
+    lut->corr[MT6835_LUT_SIZE] = lut->corr[0];
+}
+
+void mt6835_sincos_q15(mt6835_turns_q32_t angulo, int16_t *seno, int16_t *coseno) {
+    // El coseno es el seno adelantado un cuarto de vuelta
+    mt6835_turns_q32_t angulos[2] = { angulo, angulo + (1UL << 30) };
+    int16_t salida[2];
+
+    for (int i = 0; i < 2; i++) {
+        uint32_t indice = angulos[i] >> 24;
+        int32_t frac = (angulos[i] >> 8) & 0xFFFF;
+        int32_t s0 = senoTabla[indice];
+        int32_t s1 = senoTabla[indice + 1];
+
+        salida[i] = s0 + (((s1 - s0) * frac) >> 16);
+    }
+
+    *seno = salida[0];
+    *coseno = salida[1];
+}
+
+void mt6835_foc_compute(const mt6835_foc_t *foc, uint32_t raw, mt6835_foc_sample_t *muestra) {
+    muestra->mech = mt6835_raw_to_angle21(raw);
+    muestra->status = raw & 0x07;
+
+    // La vuelta electrica es el overflow de 32 bits, no hace falta modulo
+    muestra->elec = mt6835_angle21_to_q32(muestra->mech) * foc->polePairs + foc->elecOffset;
+
+    mt6835_sincos_q15(muestra->elec, &muestra->sin, &muestra->cos);
+}
@@ -0,0 +1,90 @@
+#ifndef MT6835_ANGLE_H
+#define MT6835_ANGLE_H
+
+#include <stdint.h>
+
+// Tipos de angulo en punto fijo, todas las conversiones son enteras y sin saltos
+typedef uint32_t mt6835_angle21_t;      // 21 bits, 2^21 = una vuelta
+typedef uint32_t mt6835_turns_q32_t;    // Q32 de vuelta, 2^32 = una vuelta (la vuelta es el overflow natural)
+
+#define MT6835_ANGLE21_MASK 0x1FFFFF
+
+// Palabra de mt6835_get_angle (21 bits de angulo + 3 de estado) a angulo de 21 bits
+static inline mt6835_angle21_t mt6835_raw_to_angle21(uint32_t raw) {
+    return (raw >> 3) & MT6835_ANGLE21_MASK;
+}
+
+static inline mt6835_turns_q32_t mt6835_angle21_to_q32(mt6835_angle21_t angulo) {
+    return angulo << 11;
+}
+
+// Redondea al LSB mas cercano
+static inline mt6835_angle21_t mt6835_q32_to_angle21(mt6835_turns_q32_t vueltas) {
+    return ((vueltas + (1 << 10)) >> 11) & MT6835_ANGLE21_MASK;
+}
+
+// Milesimas de grado redondeadas, 0 a 360000
+static inline uint32_t mt6835_angle21_to_mdeg(mt6835_angle21_t angulo) {
+    return ((uint64_t)angulo * 360000 + (1 << 20)) >> 21;
+}
+
+// Multiplico por 2^53 / 360000 en vez de dividir, exacto para 0..360000 mdeg
+static inline mt6835_angle21_t mt6835_mdeg_to_angle21(uint32_t mdeg) {
+    return (((uint64_t)mdeg * 25019997930ULL + (1ULL << 31)) >> 32) & MT6835_ANGLE21_MASK;
+}
+
+// Diferencia a - b con signo en el rango [-2^20, 2^20)
+static inline int32_t mt6835_angle21_diff(mt6835_angle21_t a, mt6835_angle21_t b) {
+    return (int32_t)((a - b) << 11) >> 11;
+}
+
+// Correccion de linealidad por software: tabla de MT6835_LUT_SIZE tramos indexada por los bits
+// altos del angulo de 21 bits, con interpolacion lineal. Sin dependencias de ESP-IDF
+
+#ifndef MT6835_LUT_BITS
+#define MT6835_LUT_BITS 8       // 256 tramos, 514 bytes de tabla
+#endif
+
+#define MT6835_LUT_SIZE  (1 << MT6835_LUT_BITS)
+#define MT6835_LUT_SHIFT (21 - MT6835_LUT_BITS)
+
+typedef struct {
+    int16_t corr[MT6835_LUT_SIZE + 1];  // Cuentas de 21 bits a sumar, corr[SIZE] = corr[0] para el ultimo tramo
+} mt6835_lut_t;
+
+// raw con el formato de mt6835_get_angle, los bits de estado se conservan
+static inline uint32_t mt6835_lut_apply(const mt6835_lut_t *lut, uint32_t raw) {
+    uint32_t angulo = (raw >> 3) & 0x1FFFFF;
+    uint32_t indice = angulo >> MT6835_LUT_SHIFT;
+    int32_t frac = angulo & ((1 << MT6835_LUT_SHIFT) - 1);
+    int32_t c0 = lut->corr[indice];
+    int32_t c1 = lut->corr[indice + 1];
+    int32_t correccion = c0 + (((c1 - c0) * frac) >> MT6835_LUT_SHIFT);
+
+    return (((angulo + correccion) & 0x1FFFFF) << 3) | (raw & 0x07);
+}
+
+// Seno y coseno Q15 de un angulo Q32 (tabla de 256 tramos interpolada, error <= 4 LSB)
+void mt6835_sincos_q15(mt6835_turns_q32_t angulo, int16_t *seno, int16_t *coseno);
+
+// Angulo electrico para FOC a partir de la lectura del MT6835
+typedef struct {
+    uint8_t polePairs;
+    mt6835_turns_q32_t elecOffset;      // Se suma al angulo electrico (alineacion del rotor)
+} mt6835_foc_t;
+
+typedef struct {
+    mt6835_angle21_t mech;              // Angulo mecanico de 21 bits
+    mt6835_turns_q32_t elec;            // Angulo electrico, 2^32 = una vuelta electrica
+    int16_t sin;                        // Q15
+    int16_t cos;                        // Q15
+    uint8_t status;                     // Bits de estado de ANGLE_LOW
+} mt6835_foc_sample_t;
+
+void mt6835_foc_compute(const mt6835_foc_t *foc, uint32_t raw, mt6835_foc_sample_t *muestra);
+
+void mt6835_lut_apply_batch(const mt6835_lut_t *lut, uint32_t *raw, uint32_t cantidad);
+// Arma la tabla a partir de 'cantidad' correcciones equiespaciadas en una vuelta (por ejemplo la tabla NLC)
+void mt6835_lut_build(mt6835_lut_t *lut, const int32_t *puntos, uint32_t cantidad);
+
+#endif
@@ -0,0 +1,200 @@
+#include "mt6835_capture.h"
+#include "mt6835_angle.h"
+#include <string.h>
+
+static inline uint64_t zigzag(int64_t valor) {
+    return ((uint64_t)valor << 1) ^ (uint64_t)(valor >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t valor) {
+    return (int64_t)(valor >> 1) ^ -(int64_t)(valor & 1);
+}
+
+static size_t put_varint(uint8_t *buf, uint64_t valor) {
+    size_t n = 0;
+
+    while (valor >= 0x80) {
+        buf[n++] = (valor & 0x7F) | 0x80;
+        valor >>= 7;
+    }
+
+    buf[n++] = valor;
+
+    return n;
+}
+
+// Retorna los bytes leidos, 0 si el varint esta cortado
+static size_t get_varint(const uint8_t *buf, size_t len, uint64_t *valor) {
+    uint64_t resultado = 0;
+
+    for (size_t n = 0; n < len && n < 10; n++) {
+        resultado |= (uint64_t)(buf[n] & 0x7F) << (7 * n);
+
+        if (!(buf[n] & 0x80)) {
+            *valor = resultado;
+            return n + 1;
+        }
+    }
+
+    return 0;
+}
+
+void mt6835_capture_init(mt6835_capture_t *capture, uint32_t intervaloKeyframe) {
+    memset(capture, 0, sizeof(*capture));
+    capture->intervalo = (intervaloKeyframe > 0) ? intervaloKeyframe : MT6835_CAPTURE_KEYFRAME;
+}
+
+void mt6835_capture_keyframe(mt6835_capture_t *capture) {
+    capture->desdeKeyframe = 0;
+}
+
+size_t mt6835_capture_encode(mt6835_capture_t *enc, const mt6835_sample_t *muestra, uint8_t *buf, size_t cap) {
+    uint8_t registro[MT6835_CAPTURE_MAX_RECORD];
+    size_t n = 0;
+    uint32_t angulo = mt6835_raw_to_angle21(muestra->raw);
+    uint8_t flags = (muestra->raw & 0x07) | ((muestra->crcOk == 0) << 3);
+    int32_t delta = 0;
+    int64_t dt = 0;
+
+    if (enc->desdeKeyframe == 0) {
+        registro[n++] = 1 | (flags << 1);
+
+        for (int i = 0; i < 8; i++) {
+            registro[n++] = (uint64_t)muestra->timestamp >> (8 * i);
+        }
+
+        registro[n++] = angulo >> 16;
+        registro[n++] = angulo >> 8;
+        registro[n++] = angulo;
+    } else {
+        delta = mt6835_angle21_diff(angulo, enc->angulo);
+        dt = muestra->timestamp - enc->timestamp;
+
+        uint64_t cabecera = (zigzag(delta - enc->delta) << 3) | ((dt != enc->dt) << 2) | ((flags != enc->flags) << 1);
+
+        n = put_varint(registro, cabecera);
+
+        if (flags != enc->flags) {
+            registro[n++] = flags;
+        }
+
+        if (dt != enc->dt) {
+            n += put_varint(&registro[n], zigzag(dt - enc->dt));
+        }
+    }
+
+    if (flags & 0x08) {
+        registro[n++] = muestra->crc;
+    }
+
+    if (n > cap) {
+        return 0;
+    }
+
+    memcpy(buf, registro, n);
+
+    enc->angulo = angulo;
+    enc->delta = delta;
+    enc->timestamp = muestra->timestamp;
+    enc->dt = dt;
+    enc->flags = flags;
+
+    if (++enc->desdeKeyframe >= enc->intervalo) {
+        enc->desdeKeyframe = 0;
+    }
+
+    return n;
+}
+
+size_t mt6835_capture_decode(mt6835_capture_t *dec, const uint8_t *buf, size_t len, mt6835_sample_t *muestra) {
+    size_t n = 0;
+    uint32_t angulo;
+    int32_t delta = 0;
+    int64_t timestamp;
+    int64_t dt = 0;
+    uint8_t flags;
+
+    if (len == 0) {
+        return 0;
+    }
+
+    if (buf[0] & 0x01) {
+        if (len < 12) {
+            return 0;
+        }
+
+        flags = (buf[0] >> 1) & 0x0F;
+
+        uint64_t ts = 0;
+
+        for (int i = 0; i < 8; i++) {
+            ts |= (uint64_t)buf[1 + i] << (8 * i);
+        }
+
+        timestamp = (int64_t)ts;
+        angulo = (((uint32_t)buf[9] << 16) | ((uint32_t)buf[10] << 8) | buf[11]) & MT6835_ANGLE21_MASK;
+        n = 12;
+    } else {
+        uint64_t cabecera, valor;
+
+        if (!dec->sincronizado) {
+            return 0;
+        }
+
+        n = get_varint(buf, len, &cabecera);
+
+        if (n == 0) {
+            return 0;
+        }
+
+        flags = dec->flags;
+
+        if (cabecera & 0x02) {
+            if (n >= len) {
+                return 0;
+            }
+
+            flags = buf[n++] & 0x0F;
+        }
+
+        dt = dec->dt;
+
+        if (cabecera & 0x04) {
+            size_t m = get_varint(&buf[n], len - n, &valor);
+
+            if (m == 0) {
+                return 0;
+            }
+
+            n += m;
+            dt += unzigzag(valor);
+        }
+
+        delta = dec->delta + (int32_t)unzigzag(cabecera >> 3);
+        angulo = (dec->angulo + delta) & MT6835_ANGLE21_MASK;
+        timestamp = dec->timestamp + dt;
+    }
+
+    muestra->crc = 0;
+
+    if (flags & 0x08) {
+        if (n >= len) {
+            return 0;
+        }
+
+        muestra->crc = buf[n++];
+    }
+
+    muestra->raw = (angulo << 3) | (flags & 0x07);
+    muestra->crcOk = (flags & 0x08) == 0;
+    muestra->timestamp = timestamp;
+
+    dec->angulo = angulo;
+    dec->delta = delta;
+    dec->timestamp = timestamp;
+    dec->dt = dt;
+    dec->flags = flags;
+    dec->sincronizado = 1;
+
+    return n;
+}
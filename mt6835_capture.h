@@ -0,0 +1,46 @@
+#ifndef MT6835_CAPTURE_H
+#define MT6835_CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "mt6835_ring.h"
+
+// Formato compacto para capturas de angulo, sin dependencias de ESP-IDF para decodificar en host
+//
+// Cada muestra es un registro:
+//  - Keyframe: byte 0 = 1 | flags << 1, timestamp int64 LE (8 bytes), angulo 21 bits BE (3 bytes)
+//  - Delta: varint de (zigzag(dd angulo) << 3 | hayTimestamp << 2 | hayFlags << 1), bit 0 siempre en 0
+//    seguido de flags (1 byte) si cambiaron y de zigzag(dd timestamp) en varint si no es 0
+// dd = diferencia de la diferencia con la muestra anterior, el angulo da la vuelta en 2^21
+// flags = bits de estado | crc invalido << 3, si el CRC es invalido se agrega el CRC recibido (1 byte)
+// La decodificacion puede empezar en cualquier keyframe
+
+#ifndef MT6835_CAPTURE_KEYFRAME
+#define MT6835_CAPTURE_KEYFRAME 256     // Muestras entre keyframes
+#endif
+
+#define MT6835_CAPTURE_MAX_RECORD 16    // Bytes maximos de un registro
+
+// Estado del codificador o decodificador, no guarda muestras
+typedef struct {
+    uint32_t angulo;            // 21 bits
+    int32_t delta;              // Cuentas por muestra
+    int64_t timestamp;          // us
+    int64_t dt;                 // us
+    uint8_t flags;
+    uint8_t sincronizado;       // Decodificador: ya paso un keyframe
+    uint32_t desdeKeyframe;     // Codificador: muestras desde el ultimo keyframe
+    uint32_t intervalo;         // Codificador: muestras entre keyframes
+} mt6835_capture_t;
+
+void mt6835_capture_init(mt6835_capture_t *capture, uint32_t intervaloKeyframe);   // 0 = MT6835_CAPTURE_KEYFRAME
+void mt6835_capture_keyframe(mt6835_capture_t *capture);   // La proxima muestra sale como keyframe (ej. inicio de pagina de flash)
+
+// Retorna los bytes escritos, 0 si no entra en cap (el estado no cambia)
+size_t mt6835_capture_encode(mt6835_capture_t *enc, const mt6835_sample_t *muestra, uint8_t *buf, size_t cap);
+
+// Retorna los bytes consumidos, 0 si el registro esta incompleto o falta un keyframe previo
+// crc solo se recupera en las muestras con crcOk == 0, en las demas queda en 0
+size_t mt6835_capture_decode(mt6835_capture_t *dec, const uint8_t *buf, size_t len, mt6835_sample_t *muestra);
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef MT6835_RING_H
+#define MT6835_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// Buffer circular lock-free de un productor y un consumidor para muestras de angulo
+// No depende de ESP-IDF para poder probarlo en host
+
+#ifndef MT6835_RING_SIZE
+#define MT6835_RING_SIZE 256    // Debe ser potencia de 2
+#endif
+
+_Static_assert((MT6835_RING_SIZE & (MT6835_RING_SIZE - 1)) == 0, "MT6835_RING_SIZE debe ser potencia de 2");
+
+typedef struct {
+    int64_t timestamp;          // us, fin de la transaccion (ver mt6835_stamp_t), sin callbacks el momento en que se retiro
+    uint32_t raw;               // 21 bits de angulo + 3 bits de estado, igual que mt6835_get_angle (con LUT y cero fino)
+    uint8_t crc;                // CRC recibido del MT6835
+    uint8_t crcOk;              // 1 si el CRC coincide, con 0 raw queda como se recibio (sin correcciones)
+} mt6835_sample_t;
+
+typedef struct {
+    _Atomic uint32_t head;      // Solo lo escribe el productor
+    _Atomic uint32_t tail;      // Solo lo escribe el consumidor
+    uint32_t overruns;          // Muestras descartadas por buffer lleno (solo productor)
+    mt6835_sample_t samples[MT6835_RING_SIZE];
+} mt6835_ring_t;
+
+static inline void mt6835_ring_init(mt6835_ring_t *ring) {
+    atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+    ring->overruns = 0;
+}
+
+// Productor: si el buffer esta lleno se descarta la muestra nueva y se cuenta el overrun
+static inline bool mt6835_ring_push(mt6835_ring_t *ring, const mt6835_sample_t *sample) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail >= MT6835_RING_SIZE) {
+        ring->overruns++;
+        return false;
+    }
+
+    ring->samples[head & (MT6835_RING_SIZE - 1)] = *sample;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    return true;
+}
+
+// Consumidor: nunca bloquea, retorna false si no hay muestras
+static inline bool mt6835_ring_pop(mt6835_ring_t *ring, mt6835_sample_t *sample) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (head == tail) {
+        return false;
+    }
+
+    *sample = ring->samples[tail & (MT6835_RING_SIZE - 1)];
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+    return true;
+}
+
+static inline uint32_t mt6835_ring_count(mt6835_ring_t *ring) {
+    return atomic_load_explicit(&ring->head, memory_order_acquire) - atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef MT6835_SEQLOCK_H
+#define MT6835_SEQLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// Seqlock de un escritor y varios lectores sin locks, sin dependencias de ESP-IDF
+// El contador es impar mientras el escritor actualiza
+
+#ifndef MT6835_SEQLOCK_RETRIES
+#define MT6835_SEQLOCK_RETRIES 64   // Intentos de lectura antes de rendirse (ej. escritor desalojado a mitad de la escritura)
+#endif
+
+// Retorna el valor del contador antes de la escritura
+static inline uint32_t mt6835_seqlock_write_begin(_Atomic uint32_t *seq) {
+    uint32_t valor = atomic_load_explicit(seq, memory_order_relaxed);
+
+    atomic_store_explicit(seq, valor + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    return valor;
+}
+
+static inline void mt6835_seqlock_write_end(_Atomic uint32_t *seq) {
+    uint32_t valor = atomic_load_explicit(seq, memory_order_relaxed);
+
+    atomic_store_explicit(seq, valor + 1, memory_order_release);
+}
+
+// Copia tam bytes de origen a destino sin cortes de escritura en el medio
+// Retorna false si en MT6835_SEQLOCK_RETRIES intentos el escritor no dejo una copia consistente
+static inline bool mt6835_seqlock_read(_Atomic uint32_t *seq, void *destino, const void *origen, size_t tam) {
+    for (int i = 0; i < MT6835_SEQLOCK_RETRIES; i++) {
+        uint32_t inicio = atomic_load_explicit(seq, memory_order_acquire);
+
+        if (inicio & 1) {
+            continue;
+        }
+
+        memcpy(destino, origen, tam);
+        atomic_thread_fence(memory_order_acquire);
+
+        if (atomic_load_explicit(seq, memory_order_relaxed) == inicio) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#endif
@@ -0,0 +1,166 @@
+#include <string.h>
+#include "mt6835_sim.h"
+
+// El handle de un dispositivo simulado es el puntero al modelo
+#define SIM(handle) ((mt6835_sim_t *)(void *)(handle))
+
+void mt6835_sim_init(mt6835_sim_t *sim) {
+    memset(sim, 0, sizeof(*sim));
+    sim->noiseSeed = 1;
+
+    // Modelo, no la respuesta medida del MT6835: cada paso de BW duplica la constante de tiempo
+    for (int i = 0; i < 8; i++) {
+        sim->filterShift[i] = i;
+    }
+}
+
+spi_device_handle_t mt6835_sim_handle(mt6835_sim_t *sim) {
+    return (spi_device_handle_t)(void *)sim;
+}
+
+void mt6835_sim_reset_stats(mt6835_sim_t *sim) {
+    sim->transactions = 0;
+    sim->bytes = 0;
+    sim->eepromWrites = 0;
+}
+
+void mt6835_sim_power_cycle(mt6835_sim_t *sim) {
+    memcpy(sim->regs, sim->eeprom, sizeof(sim->regs));
+}
+
+// Angulo mecanico con ruido, filtrado segun BW. Avanza el filtro una transaccion
+static uint32_t sim_filter(mt6835_sim_t *sim) {
+    uint32_t entrada = sim->angle;
+
+    if (sim->noise > 0) {
+        sim->noiseSeed = sim->noiseSeed * 1664525 + 1013904223;
+        entrada += (int32_t)((sim->noiseSeed >> 8) % (2 * sim->noise + 1)) - (int32_t)sim->noise;
+    }
+
+    uint8_t shift = sim->filterShift[sim->regs[BW] & 0x07];
+    int32_t error = mt6835_angle21_diff(entrada & 0x1FFFFF, (uint32_t)(sim->filtered >> 8) & 0x1FFFFF);
+
+    sim->filtered += ((int64_t)error * 256) >> shift;
+
+    return (uint32_t)(sim->filtered >> 8) & 0x1FFFFF;
+}
+
+// Angulo que reporta el MT6835: filtrado menos ZERO_POS (12 bits, LSB = 2^9 cuentas)
+static uint32_t sim_output_angle(mt6835_sim_t *sim) {
+    uint32_t zero = ((uint32_t)sim->regs[ZERO_HIGH] << 4) | (sim->regs[ZERO_LOW] >> 4);
+
+    return (sim_filter(sim) - (zero << 9)) & 0x1FFFFF;
+}
+
+// Al bajar CS el MT6835 congela angulo, estado y CRC
+static void sim_latch(mt6835_sim_t *sim) {
+    uint32_t raw = (sim_output_angle(sim) << 3) | (sim->status & 0x07);
+
+    sim->regs[ANGLE_HIGH] = raw >> 16;
+    sim->regs[ANGLE_MID] = raw >> 8;
+    sim->regs[ANGLE_LOW] = raw;
+    sim->regs[CRC] = calculate_crc_raw(raw) ^ (sim->corruptCrc ? 0xFF : 0x00);
+}
+
+static esp_err_t sim_transmit(spi_device_handle_t handle, spi_transaction_t *trans) {
+    mt6835_sim_t *sim = SIM(handle);
+    uint32_t n = trans->length / 8;
+    uint8_t *rx = (trans->flags & SPI_TRANS_USE_RXDATA) ? trans->rx_data : (uint8_t *)trans->rx_buffer;
+    const uint8_t *tx = (trans->flags & SPI_TRANS_USE_TXDATA) ? trans->tx_data : (const uint8_t *)trans->tx_buffer;
+    uint16_t addr = trans->addr & 0xFFF;
+
+    // Como un dispositivo agregado con .pre_cb = mt6835_spi_pre_cb y .post_cb = mt6835_spi_post_cb
+    mt6835_spi_pre_cb(trans);
+
+    sim->transactions++;
+    sim->bytes += 2 + n;        // 4 bits de comando + 12 de direccion + datos
+    sim_latch(sim);
+
+    if (rx != NULL) {
+        memset(rx, 0, n);
+    }
+
+    switch (trans->cmd) {
+        case READ:
+            if (rx != NULL && n > 0) {
+                rx[0] = sim->regs[addr & 0xFF];
+            }
+            break;
+        case WRITE:
+            // Angulo y CRC son de solo lectura
+            if (tx != NULL && n > 0 && addr != 0 && !(addr >= ANGLE_HIGH && addr <= CRC) && addr <= NLC_END) {
+                sim->regs[addr] = tx[0];
+            }
+            break;
+        case BURST_READ:
+            for (uint32_t i = 0; rx != NULL && i < n; i++) {
+                rx[i] = sim->regs[(addr + i) & 0xFF];
+            }
+            break;
+        case SET_ZERO:
+            // La posicion actual pasa a ser 0 con la resolucion de ZERO_POS
+            sim->regs[ZERO_HIGH] = sim->angle >> 13;
+            sim->regs[ZERO_LOW] = (sim->regs[ZERO_LOW] & 0x0F) | (((sim->angle >> 9) & 0x0F) << 4);
+            if (rx != NULL && n > 0) {
+                rx[0] = 0x55;
+            }
+            break;
+        case PROG_EEPROM:
+            memcpy(sim->eeprom, sim->regs, sizeof(sim->eeprom));
+            sim->eepromWrites++;
+            if (rx != NULL && n > 0) {
+                rx[0] = 0x55;
+            }
+            break;
+        default:
+            return ESP_ERR_INVALID_ARG;
+    }
+
+    sim->angle = (sim->angle + sim->velocity) & 0x1FFFFF;
+
+    mt6835_spi_post_cb(trans);
+
+    return ESP_OK;
+}
+
+static esp_err_t sim_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t espera) {
+    mt6835_sim_t *sim = SIM(handle);
+
+    if (sim->queueHead - sim->queueTail >= MT6835_SIM_QUEUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // El modelo ejecuta la transaccion al encolarla, como un bus infinitamente rapido
+    sim_transmit(handle, trans);
+    sim->queue[sim->queueHead++ % MT6835_SIM_QUEUE] = trans;
+
+    return ESP_OK;
+}
+
+static esp_err_t sim_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t espera) {
+    mt6835_sim_t *sim = SIM(handle);
+
+    if (sim->queueHead == sim->queueTail) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    *trans = sim->queue[sim->queueTail++ % MT6835_SIM_QUEUE];
+
+    return ESP_OK;
+}
+
+static esp_err_t sim_acquire_bus(spi_device_handle_t handle, TickType_t espera) {
+    return ESP_OK;
+}
+
+static void sim_release_bus(spi_device_handle_t handle) {
+}
+
+const mt6835_transport_t mt6835_sim_transport = {
+    .transmit = sim_transmit,
+    .polling_transmit = sim_transmit,
+    .queue_trans = sim_queue_trans,
+    .get_trans_result = sim_get_trans_result,
+    .acquire_bus = sim_acquire_bus,
+    .release_bus = sim_release_bus
+};
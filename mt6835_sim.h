@@ -0,0 +1,47 @@
+#ifndef MT6835_SIM_H
+#define MT6835_SIM_H
+
+#include "mt6835.h"
+
+// Modelo en memoria del MT6835 para correr el driver sin hardware
+// Se compila solo en el build de host (host/CMakeLists.txt), no forma parte del componente de ESP-IDF
+// Uso: mt6835_sim_init(&sim); mt6835_set_transport(&mt6835_sim_transport);
+//      spi_device_handle_t handle = mt6835_sim_handle(&sim);
+//      mt6835_attach(&handle);
+
+#ifndef MT6835_SIM_QUEUE
+#define MT6835_SIM_QUEUE 16     // Transacciones encoladas por dispositivo simulado
+#endif
+
+_Static_assert(MT6835_SIM_QUEUE >= MT6835_QUEUE_SIZE, "El modelo necesita la misma cola que un dispositivo real (ver MT6835_QUEUE_SIZE)");
+
+typedef struct mt6835_sim_t {
+    uint8_t regs[256];
+    uint8_t eeprom[256];
+    uint32_t angle;             // Angulo mecanico de 21 bits, antes de restar ZERO_POS
+    int32_t velocity;           // Cuentas que avanza el angulo en cada transaccion
+    uint8_t status;             // Bits de estado que devuelve ANGLE_LOW
+    uint8_t corruptCrc;         // 1: el CRC sale invertido
+    // Modelo de ruido y filtro, por defecto sin ruido y con BW = 0 sin filtro
+    uint32_t noise;             // Ruido uniforme de +-noise cuentas sobre el angulo mecanico
+    uint32_t noiseSeed;
+    uint8_t filterShift[8];     // Por valor de BW: filtro de primer orden y += (x - y) / 2^shift en cada transaccion
+    int64_t filtered;           // Estado del filtro, Q8 de cuenta sin dar la vuelta
+    // Estadisticas
+    uint32_t transactions;
+    uint32_t bytes;             // Bytes en el cable, incluyendo comando y direccion
+    uint32_t eepromWrites;
+    // Cola para queue_trans / get_trans_result
+    spi_transaction_t *queue[MT6835_SIM_QUEUE];
+    uint32_t queueHead;
+    uint32_t queueTail;
+} mt6835_sim_t;
+
+extern const mt6835_transport_t mt6835_sim_transport;
+
+void mt6835_sim_init(mt6835_sim_t *sim);
+spi_device_handle_t mt6835_sim_handle(mt6835_sim_t *sim);
+void mt6835_sim_reset_stats(mt6835_sim_t *sim);
+void mt6835_sim_power_cycle(mt6835_sim_t *sim);         // Recarga los registros desde la EEPROM
+
+#endif
@@ -0,0 +1,201 @@
+#include "mt6835_track.h"
+
+#define Q30 (1LL << 30)
+
+void mt6835_observer_init(mt6835_observer_t *obs, uint32_t bandwidthHz, uint32_t sampleHz) {
+    // d = 1 - theta = w*T = 2*pi*bw/fs en Q30, los tres polos del lazo quedan en theta
+    uint64_t d = (6746518852ULL * bandwidthHz) / sampleHz;
+
+    if (d > Q30) {
+        d = Q30;
+    }
+
+    uint64_t theta = Q30 - d;
+    uint64_t theta3 = (((theta * theta) >> 30) * theta) >> 30;
+    uint64_t d2 = (d * d) >> 30;
+
+    // g = 1 - theta^3, h = 1.5 (1 - theta)^2 (1 + theta), 2*gamma = (1 - theta)^3
+    obs->g = Q30 - theta3;
+    obs->h = (3 * d2 * (Q30 + theta)) >> 31;
+    obs->k = (d2 * d) >> 30;
+
+    obs->fs = sampleHz;
+    obs->pos = 0;
+    obs->vel = 0;
+    obs->acc = 0;
+    obs->init = 0;
+}
+
+void mt6835_observer_update(mt6835_observer_t *obs, uint32_t raw) {
+    // Angulo de 21 bits llevado a 2^32 por vuelta, asi la vuelta se maneja con overflow natural
+    uint32_t medido = (raw >> 3) << 11;
+
+    if (!obs->init) {
+        obs->pos = (uint64_t)medido << 16;
+        obs->init = 1;
+        return;
+    }
+
+    // Prediccion
+    uint64_t pos = obs->pos + obs->vel + (obs->acc >> 1);
+    int64_t vel = obs->vel + obs->acc;
+
+    // Residuo con signo, el cast a int32 resuelve el cruce por 0
+    int32_t r = (int32_t)(medido - (uint32_t)(pos >> 16));
+
+    obs->pos = pos + ((obs->g * r) >> 14);
+    obs->vel = vel + ((obs->h * r) >> 14);
+    obs->acc += (obs->k * r) >> 14;
+}
+
+uint32_t mt6835_observer_angle(const mt6835_observer_t *obs) {
+    return (uint32_t)(obs->pos >> 27) & 0x1FFFFF;
+}
+
+int32_t mt6835_observer_velocity(const mt6835_observer_t *obs) {
+    // Q16 de 2^-32 vuelta -> 2^-21 vuelta: 16 + 11 bits
+    return (int32_t)((obs->vel * obs->fs) >> 27);
+}
+
+int32_t mt6835_observer_accel(const mt6835_observer_t *obs) {
+    return (int32_t)(((obs->acc * obs->fs) >> 27) * obs->fs);
+}
+
+uint32_t mt6835_observer_predict(const mt6835_observer_t *obs, int32_t dtUs) {
+    // Velocidad en 2^-32 vuelta por segundo, el avance en Q32 da la vuelta con overflow natural
+    int64_t velocidad = (obs->vel * (int64_t)obs->fs) >> 16;
+    uint32_t angulo = (uint32_t)(obs->pos >> 16) + (uint32_t)((velocidad * dtUs) / 1000000);
+
+    // Redondeo a 21 bits
+    return ((angulo + (1 << 10)) >> 11) & 0x1FFFFF;
+}
+
+void mt6835_multiturn_init(mt6835_multiturn_t *mt, uint32_t maxStep) {
+    atomic_store_explicit(&mt->seq, 0, memory_order_relaxed);
+    mt->position = 0;
+    mt->last = 0;
+    mt->missed = 0;
+    mt->init = 0;
+
+    // El desenrollado solo es univoco si el salto real es menor a media vuelta
+    mt->maxStep = (maxStep == 0 || maxStep > (1 << 20)) ? (1 << 20) : maxStep;
+}
+
+int mt6835_multiturn_update(mt6835_multiturn_t *mt, uint32_t raw) {
+    uint32_t angulo = (raw >> 3) & 0x1FFFFF;
+    int perdida = 0;
+
+    if (!mt->init) {
+        mt->last = angulo;
+        mt->init = 1;
+
+        mt6835_seqlock_write_begin(&mt->seq);
+        mt->position = angulo;
+        mt6835_seqlock_write_end(&mt->seq);
+
+        return 0;
+    }
+
+    // Diferencia de 21 bits con signo: corro al tope de 32 bits y vuelvo con shift aritmetico
+    int32_t delta = (int32_t)((angulo - mt->last) << 11) >> 11;
+    uint32_t paso = (delta < 0) ? -(uint32_t)delta : (uint32_t)delta;
+
+    mt->last = angulo;
+
+    if (paso > mt->maxStep) {
+        mt->missed++;
+        perdida = 1;
+    }
+
+    mt6835_seqlock_write_begin(&mt->seq);
+    mt->position += delta;
+    mt6835_seqlock_write_end(&mt->seq);
+
+    return perdida;
+}
+
+int mt6835_multiturn_position(mt6835_multiturn_t *mt, int64_t *position) {
+    // En 32 bits el int64 no se lee atomico: reintento si el escritor estaba en el medio
+    return mt6835_seqlock_read(&mt->seq, position, &mt->position, sizeof(*position)) ? 0 : -1;
+}
+
+int mt6835_multiturn_turns(mt6835_multiturn_t *mt, int64_t *turns) {
+    int64_t position;
+
+    if (mt6835_multiturn_position(mt, &position) != 0) {
+        return -1;
+    }
+
+    *turns = position >> 21;
+
+    return 0;
+}
+
+uint32_t mt6835_multiturn_missed(mt6835_multiturn_t *mt) {
+    return mt->missed;
+}
+
+void mt6835_hybrid_init(mt6835_hybrid_t *hyb, const mt6835_counter_t *counter, uint16_t abzRes, int32_t ganancia, uint32_t umbral) {
+    hyb->counter = *counter;
+
+    if (hyb->counter.bits == 0 || hyb->counter.bits > 32) {
+        hyb->counter.bits = 32;
+    }
+
+    // 2^21 cuentas por vuelta / (4 * abzRes) cuentas de cuadratura por vuelta, en Q16
+    hyb->escala = (abzRes > 0) ? (1LL << 35) / abzRes : 0;
+    hyb->ganancia = (ganancia <= 0 || ganancia > 65536) ? 65536 : ganancia;
+    hyb->umbral = umbral;
+    hyb->position = 0;
+    hyb->ultimo = hyb->counter.read(hyb->counter.arg);
+    hyb->deriva = 0;
+    hyb->derivas = 0;
+    hyb->anclado = 0;
+}
+
+int64_t mt6835_hybrid_update(mt6835_hybrid_t *hyb) {
+    int32_t actual = hyb->counter.read(hyb->counter.arg);
+    uint8_t corrimiento = 32 - hyb->counter.bits;
+
+    // Diferencia con signo en el ancho del contador, resuelve el desborde
+    int32_t delta = (int32_t)(((uint32_t)actual - (uint32_t)hyb->ultimo) << corrimiento) >> corrimiento;
+
+    hyb->ultimo = actual;
+    hyb->position += delta * hyb->escala;
+
+    return hyb->position >> 16;
+}
+
+int mt6835_hybrid_anchor(mt6835_hybrid_t *hyb, uint32_t raw) {
+    uint32_t angulo = (raw >> 3) & 0x1FFFFF;
+
+    mt6835_hybrid_update(hyb);
+
+    // El primer anclaje fija la vuelta y el offset entre contador y angulo absoluto
+    if (!hyb->anclado) {
+        hyb->position = (int64_t)angulo << 16;
+        hyb->anclado = 1;
+        return 0;
+    }
+
+    int32_t error = (int32_t)((angulo - (uint32_t)(hyb->position >> 16)) << 11) >> 11;
+    uint32_t magnitud = (error < 0) ? -(uint32_t)error : (uint32_t)error;
+
+    hyb->deriva = error;
+    hyb->position += (int64_t)error * hyb->ganancia;
+
+    if (magnitud > hyb->umbral) {
+        hyb->derivas++;
+        return 1;
+    }
+
+    return 0;
+}
+
+int64_t mt6835_hybrid_position(const mt6835_hybrid_t *hyb) {
+    return hyb->position >> 16;
+}
+
+uint32_t mt6835_hybrid_angle(const mt6835_hybrid_t *hyb) {
+    return (uint32_t)(hyb->position >> 16) & 0x1FFFFF;
+}
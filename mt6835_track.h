@@ -0,0 +1,74 @@
+#ifndef MT6835_TRACK_H
+#define MT6835_TRACK_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "mt6835_seqlock.h"
+
+// Observador de seguimiento de angulo (filtro alfa-beta-gamma con memoria desvaneciente)
+// Todo en punto fijo, tiempo constante por muestra y sin dependencias de ESP-IDF
+
+typedef struct {
+    uint64_t pos;               // Q16 de 2^-32 vuelta, solo importan los 48 bits bajos (vuelta completa = 2^48)
+    int64_t vel;                // Q16 de 2^-32 vuelta por muestra
+    int64_t acc;                // Q16 de 2^-32 vuelta por muestra^2
+    int64_t g, h, k;            // Ganancias Q30 (k ya incluye el factor 2 de gamma)
+    uint32_t fs;                // Frecuencia de muestreo en Hz
+    uint8_t init;
+} mt6835_observer_t;
+
+void mt6835_observer_init(mt6835_observer_t *obs, uint32_t bandwidthHz, uint32_t sampleHz);
+void mt6835_observer_update(mt6835_observer_t *obs, uint32_t raw);      // raw con el formato de mt6835_get_angle
+uint32_t mt6835_observer_angle(const mt6835_observer_t *obs);           // 21 bits
+int32_t mt6835_observer_velocity(const mt6835_observer_t *obs);         // Cuentas de 21 bits por segundo
+int32_t mt6835_observer_accel(const mt6835_observer_t *obs);            // Cuentas de 21 bits por segundo^2
+// Angulo de 21 bits extrapolado dtUs despues de la ultima muestra con la velocidad estimada
+// |dtUs| hasta 1 s y velocidad hasta 2048 vueltas/s
+uint32_t mt6835_observer_predict(const mt6835_observer_t *obs, int32_t dtUs);
+
+// Posicion multivuelta: un escritor (la tarea que lee el angulo) y varios lectores sin locks (seqlock)
+typedef struct {
+    _Atomic uint32_t seq;       // Impar mientras el escritor actualiza
+    int64_t position;           // Cuentas de 21 bits acumuladas desde el init
+    uint32_t last;              // Ultimo angulo de 21 bits
+    uint32_t maxStep;           // Salto maximo esperado entre muestras, en cuentas
+    uint32_t missed;            // Muestras con salto mayor a maxStep
+    uint8_t init;
+} mt6835_multiturn_t;
+
+void mt6835_multiturn_init(mt6835_multiturn_t *mt, uint32_t maxStep);      // maxStep = 0 usa media vuelta
+int mt6835_multiturn_update(mt6835_multiturn_t *mt, uint32_t raw);         // Retorna 1 si se detecto muestra perdida
+// Lectores: retornan 0, o -1 si el escritor no termino una actualizacion en MT6835_SEQLOCK_RETRIES intentos
+int mt6835_multiturn_position(mt6835_multiturn_t *mt, int64_t *position);
+int mt6835_multiturn_turns(mt6835_multiturn_t *mt, int64_t *turns);        // Vueltas completas (floor)
+uint32_t mt6835_multiturn_missed(mt6835_multiturn_t *mt);
+
+// Contador de cuadratura por hardware (ej. PCNT): read devuelve la cuenta acumulada, x4 (cada flanco de A y B)
+// Solo importan los bits bajos, el desborde del contador se resuelve con la diferencia de "bits" bits
+// Si el contador cuenta al reves que el angulo SPI (ABZ_SWAP, ROT_DIR), invertir el signo en read
+typedef struct {
+    int32_t (*read)(void *arg);
+    void *arg;
+    uint8_t bits;               // Ancho del contador, 1 a 32
+} mt6835_counter_t;
+
+// Estimador hibrido: posicion a alta tasa desde el contador ABZ, anclada cada tanto al angulo absoluto SPI
+typedef struct {
+    mt6835_counter_t counter;
+    int64_t escala;             // Cuentas de 21 bits por cuenta de cuadratura, Q16
+    int64_t position;           // Cuentas de 21 bits acumuladas, Q16
+    int32_t ultimo;             // Ultima lectura del contador
+    int32_t ganancia;           // Q16, fraccion del error que se corrige en cada anclaje (65536 = reanclar completo)
+    uint32_t umbral;            // Cuentas de 21 bits, error de anclaje que se considera deriva (> 2^21 / (4 * abzRes))
+    int32_t deriva;             // Error del ultimo anclaje (SPI - ABZ), cuentas de 21 bits
+    uint32_t derivas;           // Anclajes con |deriva| > umbral
+    uint8_t anclado;
+} mt6835_hybrid_t;
+
+void mt6835_hybrid_init(mt6835_hybrid_t *hyb, const mt6835_counter_t *counter, uint16_t abzRes, int32_t ganancia, uint32_t umbral);
+int64_t mt6835_hybrid_update(mt6835_hybrid_t *hyb);                        // Lee el contador, retorna la posicion
+int mt6835_hybrid_anchor(mt6835_hybrid_t *hyb, uint32_t raw);              // raw de mt6835_get_angle leido junto al contador, 1 si hay deriva
+int64_t mt6835_hybrid_position(const mt6835_hybrid_t *hyb);                // Cuentas de 21 bits multivuelta
+uint32_t mt6835_hybrid_angle(const mt6835_hybrid_t *hyb);                  // 21 bits
+
+#endif